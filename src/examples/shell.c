@@ -5,6 +5,8 @@
 
 static void read_line (char line[], size_t);
 static bool backspace (char **pos, char line[]);
+static void run (const char *command);
+static void run_pipeline (char *left, char *right);
 
 int
 main (void)
@@ -30,20 +32,76 @@ main (void)
         {
           /* Empty command. */
         }
-      else
+      else if (strchr (command, '|') != NULL)
         {
-          pid_t pid = exec (command);
-          if (pid != PID_ERROR)
-            printf ("\"%s\": exit code %d\n", command, wait (pid));
-          else
-            printf ("exec failed\n");
+          char *bar = strchr (command, '|');
+          *bar = '\0';
+          run_pipeline (command, bar + 1);
         }
+      else
+        run (command);
     }
 
   printf ("Shell exiting.");
   return EXIT_SUCCESS;
 }
 
+/* Executes COMMAND and waits for it. */
+static void
+run (const char *command)
+{
+  pid_t pid = exec (command);
+  if (pid != PID_ERROR)
+    printf ("\"%s\": exit code %d\n", command, wait (pid));
+  else
+    printf ("exec failed\n");
+}
+
+/* Executes LEFT with its output connected to the input of RIGHT,
+   then waits for both. */
+static void
+run_pipeline (char *left, char *right)
+{
+  char *end = left + strlen (left);
+  pid_t left_pid, right_pid;
+  int fds[2];
+
+  while (end > left && end[-1] == ' ')
+    *--end = '\0';
+  while (*right == ' ')
+    right++;
+
+  if (pipe (fds) < 0)
+    {
+      printf ("pipe failed\n");
+      return;
+    }
+
+  /* Children inherit every pipe open at exec time, so hand each end
+     over as the console descriptor and drop the spare handle before
+     starting the next child.  Otherwise RIGHT would hold a write end
+     and never see end of file.  Nothing may be printed while the
+     console is redirected. */
+  dup2 (fds[1], STDOUT_FILENO);
+  close (fds[1]);
+  left_pid = exec (left);
+  close (STDOUT_FILENO);
+
+  dup2 (fds[0], STDIN_FILENO);
+  close (fds[0]);
+  right_pid = exec (right);
+  close (STDIN_FILENO);
+
+  if (left_pid != PID_ERROR)
+    printf ("\"%s\": exit code %d\n", left, wait (left_pid));
+  else
+    printf ("exec failed\n");
+  if (right_pid != PID_ERROR)
+    printf ("\"%s\": exit code %d\n", right, wait (right_pid));
+  else
+    printf ("exec failed\n");
+}
+
 /* Reads a line of input from the user into LINE, which has room
    for SIZE bytes.  Handles backspace and Ctrl+U in the ways
    expected by Unix users.  On return, LINE will always be
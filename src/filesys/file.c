@@ -1,7 +1,10 @@
 #include "filesys/file.h"
 #include <debug.h>
+#include <string.h>
 #include "filesys/inode.h"
-#include "threads/malloc.h"
+#include "threads/palloc.h"
+#include "threads/synch.h"
+#include "threads/vaddr.h"
 
 /* An open file. */
 struct file
@@ -11,13 +14,78 @@ struct file
   bool deny_write;     /* Has file_deny_write() been called? */
 };
 
+/* Cache of free file objects.
+   Carved out of whole pages that are never returned, so a
+   process that opens and closes many files recycles the same
+   objects instead of going through malloc() every time. */
+struct file_slot
+{
+  struct file_slot *next; /* Next free slot. */
+};
+static struct file_slot *file_cache;
+static struct lock file_cache_lock;
+
+/* Initializes the file object cache. */
+void file_init(void)
+{
+  file_cache = NULL;
+  lock_init(&file_cache_lock);
+}
+
+/* Returns a zeroed file object from the cache, refilling it with
+   a fresh page if it is empty.  Returns a null pointer if no
+   page is available. */
+static struct file *
+file_cache_alloc(void)
+{
+  struct file_slot *slot;
+
+  lock_acquire(&file_cache_lock);
+  if (file_cache == NULL)
+  {
+    uint8_t *page = palloc_get_page(0);
+    size_t ofs;
+    if (page == NULL)
+    {
+      lock_release(&file_cache_lock);
+      return NULL;
+    }
+    for (ofs = 0; ofs + sizeof(struct file) <= PGSIZE; ofs += sizeof(struct file))
+    {
+      slot = (struct file_slot *)(page + ofs);
+      slot->next = file_cache;
+      file_cache = slot;
+    }
+  }
+  slot = file_cache;
+  file_cache = slot->next;
+  lock_release(&file_cache_lock);
+
+  memset(slot, 0, sizeof(struct file));
+  return (struct file *)slot;
+}
+
+/* Returns FILE to the cache. */
+static void
+file_cache_free(struct file *file)
+{
+  struct file_slot *slot = (struct file_slot *)file;
+
+  if (file == NULL)
+    return;
+  lock_acquire(&file_cache_lock);
+  slot->next = file_cache;
+  file_cache = slot;
+  lock_release(&file_cache_lock);
+}
+
 /* Opens a file for the given INODE, of which it takes ownership,
    and returns the new file.  Returns a null pointer if an
    allocation fails or if INODE is null. */
 struct file *
 file_open(struct inode *inode)
 {
-  struct file *file = calloc(1, sizeof *file);
+  struct file *file = file_cache_alloc();
   if (inode != NULL && file != NULL)
   {
     file->inode = inode;
@@ -28,7 +96,7 @@ file_open(struct inode *inode)
   else
   {
     inode_close(inode);
-    free(file);
+    file_cache_free(file);
     return NULL;
   }
 }
@@ -54,7 +122,7 @@ void file_close(struct file *file)
   {
     file_allow_write(file);
     inode_close(file->inode);
-    free(file);
+    file_cache_free(file);
   }
 }
 
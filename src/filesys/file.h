@@ -6,12 +6,14 @@
 
 struct inode;
 
+void file_init (void);
+
 /* Opening and closing files. */
 struct file *file_open (struct inode *);
 struct file *file_reopen (struct file *);
 void file_close (struct file *);
 struct inode *file_get_inode (struct file *);
-bool file_isdir (struct file *);
+bool file_is_dir (struct file *);
 
 /* Reading and writing. */
 off_t file_read (struct file *, void *, off_t);
@@ -23,6 +23,7 @@ void filesys_init(bool format)
     PANIC("No file system device found, can't initialize file system.");
 
   inode_init();
+  file_init();
   free_map_init();
 
   buffer_cache_init();
@@ -80,6 +80,7 @@ struct inode
   int open_cnt;           /* Number of openers. */
   bool removed;           /* True if deleted, false otherwise. */
   int deny_write_cnt;     /* 0: writes ok, >0: deny writes. */
+  unsigned write_cnt;     /* Writes since opened, to spot stale copies. */
   struct inode_data data; /* Inode content. */
   struct lock lock;       /* Lock for inode. */
 };
@@ -331,6 +332,7 @@ inode_open(block_sector_t sector)
   inode->sector = sector;
   inode->open_cnt = 1;
   inode->deny_write_cnt = 0;
+  inode->write_cnt = 0;
   inode->removed = false;
   lock_init(&inode->lock);
   struct inode_disk *disk_inode = calloc(1, sizeof *disk_inode);
@@ -349,6 +351,20 @@ inode_reopen(struct inode *inode)
   return inode;
 }
 
+/* Returns the number of writes to INODE since it was opened. */
+unsigned
+inode_get_write_cnt(const struct inode *inode)
+{
+  return inode->write_cnt;
+}
+
+/* Returns true if INODE has been removed. */
+bool
+inode_is_removed(const struct inode *inode)
+{
+  return inode->removed;
+}
+
 /* Returns INODE's inode number. */
 block_sector_t
 inode_get_inumber(const struct inode *inode)
@@ -585,6 +601,10 @@ off_t inode_write_at(struct inode *inode, const void *buffer_, off_t size,
     bytes_written += chunk_size;
   }
 
+  /* Count the write only now that its data is in place, so that a
+     reader that sees the old count before and after reading knows
+     the write will make its copy stale. */
+  inode->write_cnt++;
   return bytes_written;
 }
 
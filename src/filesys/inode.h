@@ -12,6 +12,8 @@ bool inode_create (block_sector_t, off_t, bool);
 struct inode *inode_open (block_sector_t);
 struct inode *inode_reopen (struct inode *);
 block_sector_t inode_get_inumber (const struct inode *);
+unsigned inode_get_write_cnt (const struct inode *);
+bool inode_is_removed (const struct inode *);
 bool inode_set_parent(block_sector_t parent, block_sector_t child);
 block_sector_t inode_get_parent(struct inode *inode);
 bool inode_is_dir(struct inode *inode);
@@ -0,0 +1,15 @@
+#ifndef __LIB_MADVISE_H
+#define __LIB_MADVISE_H
+
+/* Advice to the madvise system call about how a program will use
+   a range of its memory. */
+enum madvise_advice
+  {
+    MADV_NORMAL,                /* No particular use. */
+    MADV_RANDOM,                /* Touched in no particular order. */
+    MADV_SEQUENTIAL,            /* Touched once, in ascending order. */
+    MADV_WILLNEED,              /* Touched soon: load it now. */
+    MADV_DONTNEED               /* Not needed: drop its contents. */
+  };
+
+#endif /* lib/madvise.h */
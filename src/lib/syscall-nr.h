@@ -28,7 +28,31 @@ enum
     SYS_MKDIR,                  /* Create a directory. */
     SYS_READDIR,                /* Reads a directory entry. */
     SYS_ISDIR,                  /* Tests if a fd represents a directory. */
-    SYS_INUMBER                 /* Returns the inode number for a fd. */
+    SYS_INUMBER,                /* Returns the inode number for a fd. */
+
+    /* Asynchronous I/O. */
+    SYS_AIO_READ,               /* Start an asynchronous read. */
+    SYS_AIO_WRITE,              /* Start an asynchronous write. */
+    SYS_AIO_WAIT,               /* Wait for an asynchronous request. */
+    SYS_AIO_POLL,               /* Check an asynchronous request. */
+
+    /* Fast system call entry. */
+    SYS_SYSENTER,               /* Tests if SYSENTER may be used. */
+
+    /* Pipes. */
+    SYS_PIPE,                   /* Create a pipe. */
+    SYS_DUP2,                   /* Duplicate a descriptor. */
+
+    /* Shared memory. */
+    SYS_SHM_OPEN,               /* Open a shared memory segment. */
+    SYS_SHM_MAP,                /* Map a shared memory segment. */
+    SYS_SHM_UNMAP,              /* Unmap a shared memory segment. */
+
+    /* Virtual memory statistics. */
+    SYS_VMSTAT,                 /* Report virtual memory statistics. */
+
+    /* Memory advice. */
+    SYS_MADVISE                 /* Advise how memory will be used. */
   };
 
 #endif /* lib/syscall-nr.h */
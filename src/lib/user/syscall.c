@@ -1,9 +1,9 @@
 #include <syscall.h>
 #include "../syscall-nr.h"
 
-/* Invokes syscall NUMBER, passing no arguments, and returns the
-   return value as an `int'. */
-#define syscall0(NUMBER)                                        \
+/* Invokes syscall NUMBER through `int $0x30', passing no
+   arguments, and returns the return value as an `int'. */
+#define int_syscall0(NUMBER)                                    \
         ({                                                      \
           int retval;                                           \
           asm volatile                                          \
@@ -14,9 +14,9 @@
           retval;                                               \
         })
 
-/* Invokes syscall NUMBER, passing argument ARG0, and returns the
-   return value as an `int'. */
-#define syscall1(NUMBER, ARG0)                                           \
+/* Invokes syscall NUMBER through `int $0x30', passing argument
+   ARG0, and returns the return value as an `int'. */
+#define int_syscall1(NUMBER, ARG0)                                       \
         ({                                                               \
           int retval;                                                    \
           asm volatile                                                   \
@@ -28,9 +28,9 @@
           retval;                                                        \
         })
 
-/* Invokes syscall NUMBER, passing arguments ARG0 and ARG1, and
-   returns the return value as an `int'. */
-#define syscall2(NUMBER, ARG0, ARG1)                            \
+/* Invokes syscall NUMBER through `int $0x30', passing arguments
+   ARG0 and ARG1, and returns the return value as an `int'. */
+#define int_syscall2(NUMBER, ARG0, ARG1)                        \
         ({                                                      \
           int retval;                                           \
           asm volatile                                          \
@@ -44,9 +44,10 @@
           retval;                                               \
         })
 
-/* Invokes syscall NUMBER, passing arguments ARG0, ARG1, and
-   ARG2, and returns the return value as an `int'. */
-#define syscall3(NUMBER, ARG0, ARG1, ARG2)                      \
+/* Invokes syscall NUMBER through `int $0x30', passing arguments
+   ARG0, ARG1, and ARG2, and returns the return value as an
+   `int'. */
+#define int_syscall3(NUMBER, ARG0, ARG1, ARG2)                  \
         ({                                                      \
           int retval;                                           \
           asm volatile                                          \
@@ -61,6 +62,97 @@
           retval;                                               \
         })
 
+/* SYSENTER versions of the above.  The arguments go on the stack
+   exactly as for `int $0x30'; SYSENTER itself saves nothing, so
+   we pass the stack pointer in %ecx and the address to resume at
+   in %edx, and the kernel's SYSEXIT hands both back. */
+#define SYSENTER_CALL                                           \
+        "movl %%esp, %%ecx; movl $1f, %%edx; sysenter; 1: "
+
+#define sysenter_syscall0(NUMBER)                               \
+        ({                                                      \
+          int retval;                                           \
+          asm volatile                                          \
+            ("pushl %[number]; " SYSENTER_CALL                  \
+             "addl $4, %%esp"                                   \
+               : "=a" (retval)                                  \
+               : [number] "i" (NUMBER)                          \
+               : "ecx", "edx", "memory");                       \
+          retval;                                               \
+        })
+
+#define sysenter_syscall1(NUMBER, ARG0)                         \
+        ({                                                      \
+          int retval;                                           \
+          asm volatile                                          \
+            ("pushl %[arg0]; pushl %[number]; " SYSENTER_CALL   \
+             "addl $8, %%esp"                                   \
+               : "=a" (retval)                                  \
+               : [number] "i" (NUMBER),                         \
+                 [arg0] "g" (ARG0)                              \
+               : "ecx", "edx", "memory");                       \
+          retval;                                               \
+        })
+
+#define sysenter_syscall2(NUMBER, ARG0, ARG1)                   \
+        ({                                                      \
+          int retval;                                           \
+          asm volatile                                          \
+            ("pushl %[arg1]; pushl %[arg0]; "                   \
+             "pushl %[number]; " SYSENTER_CALL                  \
+             "addl $12, %%esp"                                  \
+               : "=a" (retval)                                  \
+               : [number] "i" (NUMBER),                         \
+                 [arg0] "r" (ARG0),                             \
+                 [arg1] "r" (ARG1)                              \
+               : "ecx", "edx", "memory");                       \
+          retval;                                               \
+        })
+
+#define sysenter_syscall3(NUMBER, ARG0, ARG1, ARG2)             \
+        ({                                                      \
+          int retval;                                           \
+          asm volatile                                          \
+            ("pushl %[arg2]; pushl %[arg1]; pushl %[arg0]; "    \
+             "pushl %[number]; " SYSENTER_CALL                  \
+             "addl $16, %%esp"                                  \
+               : "=a" (retval)                                  \
+               : [number] "i" (NUMBER),                         \
+                 [arg0] "r" (ARG0),                             \
+                 [arg1] "r" (ARG1),                             \
+                 [arg2] "r" (ARG2)                              \
+               : "ecx", "edx", "memory");                       \
+          retval;                                               \
+        })
+
+/* True if the kernel accepts SYSENTER.  Set once at startup by
+   syscall_select_entry(); until then every call uses the
+   `int $0x30' gate, which always works. */
+static bool use_sysenter;
+
+/* Invokes syscall NUMBER with 0 to 3 arguments through the entry
+   picked at startup. */
+#define syscall0(NUMBER)                                        \
+        (use_sysenter ? sysenter_syscall0 (NUMBER)              \
+                      : int_syscall0 (NUMBER))
+#define syscall1(NUMBER, ARG0)                                  \
+        (use_sysenter ? sysenter_syscall1 (NUMBER, ARG0)        \
+                      : int_syscall1 (NUMBER, ARG0))
+#define syscall2(NUMBER, ARG0, ARG1)                            \
+        (use_sysenter ? sysenter_syscall2 (NUMBER, ARG0, ARG1)  \
+                      : int_syscall2 (NUMBER, ARG0, ARG1))
+#define syscall3(NUMBER, ARG0, ARG1, ARG2)                           \
+        (use_sysenter ? sysenter_syscall3 (NUMBER, ARG0, ARG1, ARG2) \
+                      : int_syscall3 (NUMBER, ARG0, ARG1, ARG2))
+
+/* Asks the kernel whether SYSENTER may be used and switches all
+   further system calls to it if so.  Called by _start(). */
+void
+syscall_select_entry (void)
+{
+  use_sysenter = int_syscall0 (SYS_SYSENTER) != 0;
+}
+
 void
 halt (void) 
 {
@@ -182,3 +274,69 @@ inumber (int fd)
 {
   return syscall1 (SYS_INUMBER, fd);
 }
+
+aioid_t
+aio_read (int fd, void *buffer, unsigned size)
+{
+  return syscall3 (SYS_AIO_READ, fd, buffer, size);
+}
+
+aioid_t
+aio_write (int fd, const void *buffer, unsigned size)
+{
+  return syscall3 (SYS_AIO_WRITE, fd, buffer, size);
+}
+
+int
+aio_wait (aioid_t aioid)
+{
+  return syscall1 (SYS_AIO_WAIT, aioid);
+}
+
+int
+aio_poll (aioid_t aioid)
+{
+  return syscall1 (SYS_AIO_POLL, aioid);
+}
+
+int
+pipe (int fds[2])
+{
+  return syscall1 (SYS_PIPE, fds);
+}
+
+int
+dup2 (int oldfd, int newfd)
+{
+  return syscall2 (SYS_DUP2, oldfd, newfd);
+}
+
+shmid_t
+shm_open (const char *name, unsigned size)
+{
+  return syscall2 (SYS_SHM_OPEN, name, size);
+}
+
+void *
+shm_map (shmid_t shmid, void *addr)
+{
+  return (void *) syscall2 (SYS_SHM_MAP, shmid, addr);
+}
+
+bool
+shm_unmap (void *addr)
+{
+  return syscall1 (SYS_SHM_UNMAP, addr);
+}
+
+void
+vmstat (struct vmstat *st)
+{
+  syscall1 (SYS_VMSTAT, st);
+}
+
+int
+madvise (void *addr, size_t length, enum madvise_advice advice)
+{
+  return syscall3 (SYS_MADVISE, addr, length, advice);
+}
@@ -3,6 +3,9 @@
 
 #include <stdbool.h>
 #include <debug.h>
+#include <madvise.h>
+#include <stddef.h>
+#include <vmstat.h>
 
 /* Process identifier. */
 typedef int pid_t;
@@ -12,6 +15,14 @@ typedef int pid_t;
 typedef int mapid_t;
 #define MAP_FAILED ((mapid_t) -1)
 
+/* Asynchronous I/O request identifier. */
+typedef int aioid_t;
+#define AIO_FAILED ((aioid_t) -1)
+
+/* Shared memory segment identifier. */
+typedef int shmid_t;
+#define SHM_FAILED ((shmid_t) -1)
+
 /* Maximum characters in a filename written by readdir(). */
 #define READDIR_MAX_LEN 14
 
@@ -45,4 +56,28 @@ bool readdir (int fd, char name[READDIR_MAX_LEN + 1]);
 bool isdir (int fd);
 int inumber (int fd);
 
+/* Asynchronous I/O. */
+aioid_t aio_read (int fd, void *buffer, unsigned length);
+aioid_t aio_write (int fd, const void *buffer, unsigned length);
+int aio_wait (aioid_t);
+int aio_poll (aioid_t);
+
+/* Pipes. */
+int pipe (int fds[2]);
+int dup2 (int oldfd, int newfd);
+
+/* Shared memory. */
+shmid_t shm_open (const char *name, unsigned size);
+void *shm_map (shmid_t, void *addr);
+bool shm_unmap (void *addr);
+
+/* Virtual memory statistics. */
+void vmstat (struct vmstat *);
+
+/* Memory advice. */
+int madvise (void *addr, size_t length, enum madvise_advice);
+
+/* Picks the system call entry at startup.  Called by _start(). */
+void syscall_select_entry (void);
+
 #endif /* lib/user/syscall.h */
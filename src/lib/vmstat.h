@@ -0,0 +1,26 @@
+#ifndef __LIB_VMSTAT_H
+#define __LIB_VMSTAT_H
+
+/* Virtual memory statistics, as returned by the vmstat system
+   call.  Fault and eviction counts are totals since boot. */
+struct vmstat
+  {
+    /* Whole system. */
+    unsigned zero_faults;       /* Pages filled with zeros. */
+    unsigned file_faults;       /* Pages read from a file. */
+    unsigned swap_faults;       /* Pages read back from swap. */
+    unsigned stack_faults;      /* Faults that grew a stack. */
+    unsigned clean_evictions;   /* Frames evicted without a write. */
+    unsigned dirty_evictions;   /* Frames written out when evicted. */
+    unsigned frames_used;       /* User frames in use. */
+    unsigned frames;            /* User frames in all. */
+    unsigned swap_used;         /* Swap slots in use. */
+    unsigned swap_slots;        /* Swap slots in all. */
+
+    /* Calling process. */
+    unsigned page_faults;       /* Page faults it took. */
+    unsigned resident_pages;    /* Its pages held in frames. */
+    unsigned swapped_pages;     /* Its pages held in swap. */
+  };
+
+#endif /* lib/vmstat.h */
@@ -0,0 +1,29 @@
+/* Passes request ids that were never handed out or that were
+   already collected to aio_wait() and aio_poll(), which must
+   return -1, and submits a request on a bad descriptor, which
+   must fail. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void) 
+{
+  char buffer[64];
+  aioid_t id;
+  int handle;
+
+  CHECK (aio_poll (1234) == -1, "poll unknown request");
+  CHECK (aio_wait (1234) == -1, "wait for unknown request");
+  CHECK (aio_read (1234, buffer, sizeof buffer) == AIO_FAILED,
+         "aio_read on bad fd");
+
+  CHECK ((handle = open ("sample.txt")) > 1, "open \"sample.txt\"");
+  CHECK ((id = aio_read (handle, buffer, sizeof buffer)) != AIO_FAILED,
+         "aio_read");
+  CHECK (aio_wait (id) == sizeof buffer, "wait for request");
+  CHECK (aio_wait (id) == -1, "wait for collected request");
+  CHECK (aio_poll (id) == -1, "poll collected request");
+  close (handle);
+}
@@ -0,0 +1,18 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(aio-bad-id) begin
+(aio-bad-id) poll unknown request
+(aio-bad-id) wait for unknown request
+(aio-bad-id) aio_read on bad fd
+(aio-bad-id) open "sample.txt"
+(aio-bad-id) aio_read
+(aio-bad-id) wait for request
+(aio-bad-id) wait for collected request
+(aio-bad-id) poll collected request
+(aio-bad-id) end
+aio-bad-id: exit(0)
+EOF
+pass;
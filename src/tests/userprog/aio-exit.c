@@ -0,0 +1,21 @@
+/* Runs a child that queues asynchronous writes and exits
+   without collecting them.  Its exit must wait for them, so the
+   file holds all of the data once the parent's wait returns. */
+
+#include <syscall.h>
+#include "tests/userprog/aio-exit.h"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void) 
+{
+  static char data[AIO_EXIT_SIZE];
+  size_t i;
+
+  for (i = 0; i < sizeof data; i++)
+    data[i] = aio_exit_byte (i);
+  CHECK (create ("data", sizeof data), "create \"data\"");
+  msg ("wait(exec()) = %d", wait (exec ("child-aio")));
+  check_file ("data", data, sizeof data);
+}
@@ -0,0 +1,18 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(aio-exit) begin
+(aio-exit) create "data"
+(child-aio) open "data"
+(child-aio) exit with 8 writes pending
+child-aio: exit(0)
+(aio-exit) wait(exec()) = 0
+(aio-exit) open "data" for verification
+(aio-exit) verified contents of "data"
+(aio-exit) close "data"
+(aio-exit) end
+aio-exit: exit(0)
+EOF
+pass;
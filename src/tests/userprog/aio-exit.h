@@ -0,0 +1,18 @@
+#ifndef TESTS_USERPROG_AIO_EXIT_H
+#define TESTS_USERPROG_AIO_EXIT_H
+
+#include <stddef.h>
+
+/* Requests the child of aio-exit leaves pending, and their size. */
+#define AIO_EXIT_REQ_CNT 8
+#define AIO_EXIT_REQ_SIZE 512
+#define AIO_EXIT_SIZE (AIO_EXIT_REQ_CNT * AIO_EXIT_REQ_SIZE)
+
+/* Returns the byte at offset OFS of the file aio-exit writes. */
+static inline char
+aio_exit_byte (size_t ofs)
+{
+  return 'a' + ofs % 26 + ofs / AIO_EXIT_REQ_SIZE % 2;
+}
+
+#endif /* tests/userprog/aio-exit.h */
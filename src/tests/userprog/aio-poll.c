@@ -0,0 +1,45 @@
+/* Queues more asynchronous writes than there are workers to
+   serve them and polls the last one, which must still be
+   pending, then polls it until it is done.  Once collected, a
+   request is no longer known to aio_poll(). */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define REQ_CNT 8
+#define REQ_SIZE 512
+
+static char data[REQ_CNT * REQ_SIZE];
+
+void
+test_main (void) 
+{
+  aioid_t ids[REQ_CNT];
+  int handle, status;
+  size_t i;
+
+  for (i = 0; i < sizeof data; i++)
+    data[i] = 'a' + i % 26;
+  CHECK (create ("data", sizeof data), "create \"data\"");
+  CHECK ((handle = open ("data")) > 1, "open \"data\"");
+
+  msg ("queue %d writes", REQ_CNT);
+  for (i = 0; i < REQ_CNT; i++)
+    if ((ids[i] = aio_write (handle, data + i * REQ_SIZE, REQ_SIZE))
+        == AIO_FAILED)
+      fail ("aio_write %zu failed", i);
+  CHECK (aio_poll (ids[REQ_CNT - 1]) == 0, "last write still pending");
+
+  while ((status = aio_poll (ids[REQ_CNT - 1])) == 0)
+    continue;
+  CHECK (status == 1, "last write done");
+
+  for (i = 0; i < REQ_CNT; i++)
+    if (aio_wait (ids[i]) != REQ_SIZE)
+      fail ("write %zu did not write %d bytes", i, REQ_SIZE);
+  CHECK (aio_poll (ids[REQ_CNT - 1]) == -1, "collected write is gone");
+  close (handle);
+
+  check_file ("data", data, sizeof data);
+}
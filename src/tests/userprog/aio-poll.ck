@@ -0,0 +1,19 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(aio-poll) begin
+(aio-poll) create "data"
+(aio-poll) open "data"
+(aio-poll) queue 8 writes
+(aio-poll) last write still pending
+(aio-poll) last write done
+(aio-poll) collected write is gone
+(aio-poll) open "data" for verification
+(aio-poll) verified contents of "data"
+(aio-poll) close "data"
+(aio-poll) end
+aio-poll: exit(0)
+EOF
+pass;
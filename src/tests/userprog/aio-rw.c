@@ -0,0 +1,36 @@
+/* Reads a file with two asynchronous reads in flight at once,
+   collecting them in the opposite order, then writes the data
+   back out to a new file with an asynchronous write.  Both
+   copies must match the original. */
+
+#include <syscall.h>
+#include "tests/userprog/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void) 
+{
+  size_t size = sizeof sample - 1;
+  size_t half = size / 2;
+  char buffer[sizeof sample];
+  aioid_t first, second;
+  int handle;
+
+  CHECK ((handle = open ("sample.txt")) > 1, "open \"sample.txt\"");
+  CHECK ((first = aio_read (handle, buffer, half)) != AIO_FAILED,
+         "aio_read first half");
+  CHECK ((second = aio_read (handle, buffer + half, size - half))
+         != AIO_FAILED, "aio_read second half");
+  CHECK (aio_wait (second) == (int) (size - half), "wait for second half");
+  CHECK (aio_wait (first) == (int) half, "wait for first half");
+  compare_bytes (buffer, sample, size, 0, "sample.txt");
+  close (handle);
+
+  CHECK (create ("copy.txt", size), "create \"copy.txt\"");
+  CHECK ((handle = open ("copy.txt")) > 1, "open \"copy.txt\"");
+  CHECK (aio_wait (aio_write (handle, buffer, size)) == (int) size,
+         "aio_write and wait");
+  close (handle);
+  check_file ("copy.txt", sample, size);
+}
@@ -0,0 +1,21 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(aio-rw) begin
+(aio-rw) open "sample.txt"
+(aio-rw) aio_read first half
+(aio-rw) aio_read second half
+(aio-rw) wait for second half
+(aio-rw) wait for first half
+(aio-rw) create "copy.txt"
+(aio-rw) open "copy.txt"
+(aio-rw) aio_write and wait
+(aio-rw) open "copy.txt" for verification
+(aio-rw) verified contents of "copy.txt"
+(aio-rw) close "copy.txt"
+(aio-rw) end
+aio-rw: exit(0)
+EOF
+pass;
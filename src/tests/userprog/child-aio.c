@@ -0,0 +1,29 @@
+/* Child process run by aio-exit test.
+
+   Queues asynchronous writes to "data" and exits without waiting
+   for them. */
+
+#include <syscall.h>
+#include "tests/userprog/aio-exit.h"
+#include "tests/lib.h"
+
+int
+main (void) 
+{
+  static char data[AIO_EXIT_SIZE];
+  int handle;
+  size_t i;
+
+  test_name = "child-aio";
+
+  for (i = 0; i < sizeof data; i++)
+    data[i] = aio_exit_byte (i);
+  CHECK ((handle = open ("data")) > 1, "open \"data\"");
+  for (i = 0; i < AIO_EXIT_REQ_CNT; i++)
+    if (aio_write (handle, data + i * AIO_EXIT_REQ_SIZE, AIO_EXIT_REQ_SIZE)
+        == AIO_FAILED)
+      fail ("aio_write %zu failed", i);
+  msg ("exit with %d writes pending", AIO_EXIT_REQ_CNT);
+
+  return 0;
+}
@@ -0,0 +1,11 @@
+/* Child process run by exec-bench.
+   Returns its argument count, after checking that argv ends in
+   a null pointer, without printing anything. */
+
+#include <stddef.h>
+
+int
+main (int argc, char *argv[])
+{
+  return argv[argc] == NULL ? argc : -1;
+}
@@ -0,0 +1,54 @@
+/* Child process run by fpu-switch test.
+
+   Takes its number, 1 or 2, and the descriptors to read and write
+   the token through as arguments.  Loads values of its own into
+   the x87 and SSE registers, then passes the token back and forth
+   with the other child, checking its values every time it gets
+   the CPU back.  Child 1 sends first.  Exits with its number. */
+
+#include <stdlib.h>
+#include <syscall.h>
+#include "tests/userprog/fpu.h"
+#include "tests/lib.h"
+
+#define ROUNDS 100
+
+/* Fails unless the registers still hold the values for child ID. */
+static void
+check (int id, int round)
+{
+  int32_t x87;
+  uint32_t sse;
+
+  fpu_read (&x87, &sse);
+  if (x87 != 1000 * id || sse != 0x01010101u * id)
+    fail ("round %d: registers hold %d and %#x", round, x87, sse);
+}
+
+int
+main (int argc, char *argv[]) 
+{
+  int id, in, out, round;
+  char token = 't';
+
+  test_name = "child-fpu";
+  if (argc != 4)
+    fail ("bad command-line arguments");
+  id = atoi (argv[1]);
+  in = atoi (argv[2]);
+  out = atoi (argv[3]);
+
+  fpu_load (1000 * id, 0x01010101u * id);
+  for (round = 0; round < ROUNDS; round++)
+    {
+      if (id == 1 && write (out, &token, 1) != 1)
+        fail ("write failed");
+      if (read (in, &token, 1) != 1)
+        fail ("read failed");
+      check (id, round);
+      if (id == 2 && write (out, &token, 1) != 1)
+        fail ("write failed");
+    }
+
+  return id;
+}
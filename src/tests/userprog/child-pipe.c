@@ -0,0 +1,34 @@
+/* Child process run by pipe-exec test.
+
+   Closes the write end of the pipe passed as the first
+   command-line argument, then reads its standard input, the
+   inherited read end, up to end of file.  Says nothing before
+   then, so that its output cannot mix with the parent's.  Exits
+   with the number of bytes read. */
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <syscall.h>
+#include "tests/lib.h"
+
+int
+main (int argc UNUSED, char *argv[]) 
+{
+  char buffer[64];
+  int total = 0;
+  int n;
+
+  test_name = "child-pipe";
+
+  if (!isdigit (*argv[1]))
+    fail ("bad command-line arguments");
+  close (atoi (argv[1]));
+  while ((n = read (STDIN_FILENO, buffer, sizeof buffer)) > 0)
+    total += n;
+  if (n < 0)
+    fail ("read failed");
+  msg ("read %d bytes", total);
+
+  return total;
+}
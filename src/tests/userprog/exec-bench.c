@@ -0,0 +1,24 @@
+/* Executes a child with arguments and waits for it, many times in
+   a row, to measure how fast processes are created, loaded and
+   reaped.  The check script reports the timer ticks the run took,
+   for comparing kernels. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define EXEC_CNT 100
+
+void
+test_main (void)
+{
+  int i;
+
+  msg ("exec and wait %d times", EXEC_CNT);
+  for (i = 0; i < EXEC_CNT; i++)
+    {
+      int status = wait (exec ("child-argc one two  three"));
+      if (status != 4)
+        fail ("child %d exited with %d, not 4", i, status);
+    }
+}
@@ -0,0 +1,18 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([join ('',
+		       "(exec-bench) begin\n",
+		       "(exec-bench) exec and wait 100 times\n",
+		       "child-argc: exit(4)\n" x 100,
+		       "(exec-bench) end\n",
+		       "exec-bench: exit(0)\n")]);
+
+# Report how long the run took.
+our ($test);
+my ($ticks) = "?";
+foreach (read_text_file ("$test.output")) {
+    $ticks = $1 if /^Timer: (\d+) ticks/;
+}
+pass ("100 exec and wait in $ticks timer ticks");
@@ -0,0 +1,37 @@
+/* Runs two children that each keep their own values in the x87
+   and SSE registers while they pass a token back and forth
+   through a pair of pipes, so that every pass switches from one
+   to the other.  Neither may ever see the other's values, nor
+   the parent's, which must find its own intact at the end. */
+
+#include <stdio.h>
+#include <syscall.h>
+#include "tests/userprog/fpu.h"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void) 
+{
+  int ab[2], ba[2];
+  char cmd[64];
+  pid_t a, b;
+  int32_t x87;
+  uint32_t sse;
+
+  CHECK (pipe (ab) == 0 && pipe (ba) == 0, "create pipes");
+  fpu_load (-3, 0x33333333);
+
+  /* Child 1 reads from BA and writes to AB, child 2 the reverse */
+  snprintf (cmd, sizeof cmd, "child-fpu 1 %d %d", ba[0], ab[1]);
+  CHECK ((a = exec (cmd)) != -1, "exec child 1");
+  snprintf (cmd, sizeof cmd, "child-fpu 2 %d %d", ab[0], ba[1]);
+  CHECK ((b = exec (cmd)) != -1, "exec child 2");
+  msg ("wait for child 1: %d", wait (a));
+  msg ("wait for child 2: %d", wait (b));
+
+  fpu_read (&x87, &sse);
+  if (x87 != -3 || sse != 0x33333333)
+    fail ("parent's registers hold %d and %#x", x87, sse);
+  msg ("parent's registers intact");
+}
@@ -0,0 +1,42 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF', <<'EOF', <<'EOF']);
+(fpu-switch) begin
+(fpu-switch) create pipes
+(fpu-switch) exec child 1
+(fpu-switch) exec child 2
+child-fpu: exit(1)
+(fpu-switch) wait for child 1: 1
+child-fpu: exit(2)
+(fpu-switch) wait for child 2: 2
+(fpu-switch) parent's registers intact
+(fpu-switch) end
+fpu-switch: exit(0)
+EOF
+(fpu-switch) begin
+(fpu-switch) create pipes
+(fpu-switch) exec child 1
+(fpu-switch) exec child 2
+child-fpu: exit(1)
+child-fpu: exit(2)
+(fpu-switch) wait for child 1: 1
+(fpu-switch) wait for child 2: 2
+(fpu-switch) parent's registers intact
+(fpu-switch) end
+fpu-switch: exit(0)
+EOF
+(fpu-switch) begin
+(fpu-switch) create pipes
+(fpu-switch) exec child 1
+(fpu-switch) exec child 2
+child-fpu: exit(2)
+child-fpu: exit(1)
+(fpu-switch) wait for child 1: 1
+(fpu-switch) wait for child 2: 2
+(fpu-switch) parent's registers intact
+(fpu-switch) end
+fpu-switch: exit(0)
+EOF
+pass;
@@ -0,0 +1,28 @@
+#ifndef TESTS_USERPROG_FPU_H
+#define TESTS_USERPROG_FPU_H
+
+#include <stdint.h>
+
+/* User programs are built with -msoft-float, so the compiler
+   never touches the FPU or SSE registers on its own.  These put
+   values into them, and take them out again, by hand. */
+
+/* Resets the x87 FPU, then pushes X87 onto its stack and puts the
+   bits of SSE in the low 32 bits of XMM0. */
+static inline void
+fpu_load (int32_t x87, uint32_t sse)
+{
+  asm volatile ("finit; fildl %0" : : "m" (x87));
+  asm volatile ("movss %0, %%xmm0" : : "m" (sse));
+}
+
+/* Stores the value on top of the x87 stack, without popping it,
+   in *X87 and the low 32 bits of XMM0 in *SSE. */
+static inline void
+fpu_read (int32_t *x87, uint32_t *sse)
+{
+  asm volatile ("fistl %0" : "=m" (*x87));
+  asm volatile ("movss %%xmm0, %0" : "=m" (*sse));
+}
+
+#endif /* tests/userprog/fpu.h */
@@ -0,0 +1,22 @@
+/* Reads the rest of a pipe after its write end is closed, then
+   reads once more, which must report end of file instead of
+   waiting. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void) 
+{
+  char buffer[16];
+  int fds[2];
+
+  CHECK (pipe (fds) == 0, "pipe");
+  CHECK (write (fds[1], "abc", 3) == 3, "write 3 bytes");
+  msg ("close write end");
+  close (fds[1]);
+  CHECK (read (fds[0], buffer, sizeof buffer) == 3, "read 3 bytes");
+  CHECK (read (fds[0], buffer, sizeof buffer) == 0, "read end of file");
+  close (fds[0]);
+}
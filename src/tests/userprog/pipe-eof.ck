@@ -0,0 +1,15 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(pipe-eof) begin
+(pipe-eof) pipe
+(pipe-eof) write 3 bytes
+(pipe-eof) close write end
+(pipe-eof) read 3 bytes
+(pipe-eof) read end of file
+(pipe-eof) end
+pipe-eof: exit(0)
+EOF
+pass;
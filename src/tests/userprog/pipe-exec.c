@@ -0,0 +1,34 @@
+/* Makes the read end of a pipe the standard input with dup2(),
+   then runs a child, which inherits both ends of the pipe.  The
+   child closes its write end and counts the bytes on its
+   standard input up to end of file, which comes only once the
+   parent closes its write end too. */
+
+#include <stdio.h>
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void) 
+{
+  static const char message[] = "Inherited across exec.";
+  char child_cmd[128];
+  pid_t child;
+  int fds[2];
+
+  CHECK (pipe (fds) == 0, "pipe");
+  CHECK (dup2 (fds[0], STDIN_FILENO) == STDIN_FILENO,
+         "dup2 read end to stdin");
+  close (fds[0]);
+
+  snprintf (child_cmd, sizeof child_cmd, "child-pipe %d", fds[1]);
+  CHECK ((child = exec (child_cmd)) != -1, "exec \"%s\"", child_cmd);
+
+  CHECK (write (fds[1], message, strlen (message)) == (int) strlen (message),
+         "write message");
+  msg ("close write end");
+  close (fds[1]);
+  msg ("wait(exec()) = %d", wait (child));
+}
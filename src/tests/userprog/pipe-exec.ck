@@ -0,0 +1,18 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(pipe-exec) begin
+(pipe-exec) pipe
+(pipe-exec) dup2 read end to stdin
+(pipe-exec) exec "child-pipe 3"
+(pipe-exec) write message
+(pipe-exec) close write end
+(child-pipe) read 22 bytes
+child-pipe: exit(22)
+(pipe-exec) wait(exec()) = 22
+(pipe-exec) end
+pipe-exec: exit(0)
+EOF
+pass;
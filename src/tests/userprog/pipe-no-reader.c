@@ -0,0 +1,18 @@
+/* Writes to a pipe whose read end is closed, which must fail
+   instead of waiting for a reader that can never come. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void) 
+{
+  int fds[2];
+
+  CHECK (pipe (fds) == 0, "pipe");
+  msg ("close read end");
+  close (fds[0]);
+  CHECK (write (fds[1], "abc", 3) == -1, "write must fail");
+  close (fds[1]);
+}
@@ -0,0 +1,67 @@
+/* Writes several whole pages into a pipe from a page-aligned
+   buffer, which hands over each page without copying it through
+   the pipe's byte ring, and reads them into page-aligned and
+   misaligned buffers.  The data must arrive intact and in
+   order. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define PAGE_CNT 4
+
+static char src[PAGE_CNT * PAGE_SIZE] __attribute__ ((aligned (PAGE_SIZE)));
+static char dst[(PAGE_CNT + 1) * PAGE_SIZE] __attribute__ ((aligned (PAGE_SIZE)));
+
+/* Fills SRC with a pattern that differs from page to page. */
+static void
+fill (void)
+{
+  size_t i;
+
+  for (i = 0; i < sizeof src; i++)
+    src[i] = i / PAGE_SIZE + i % 251;
+}
+
+/* Reads SIZE bytes from FD into BUFFER. */
+static void
+read_all (int fd, char *buffer, size_t size)
+{
+  size_t done = 0;
+
+  while (done < size)
+    {
+      int n = read (fd, buffer + done, size - done);
+      if (n <= 0)
+        fail ("read returned %d after %zu bytes", n, done);
+      done += n;
+    }
+}
+
+void
+test_main (void) 
+{
+  int fds[2];
+
+  fill ();
+  CHECK (pipe (fds) == 0, "pipe");
+
+  CHECK (write (fds[1], src, sizeof src) == sizeof src,
+         "write %d pages", PAGE_CNT);
+  msg ("read into aligned buffer");
+  read_all (fds[0], dst, sizeof src);
+  if (memcmp (src, dst, sizeof src))
+    fail ("data read differs from data written");
+
+  CHECK (write (fds[1], src, sizeof src) == sizeof src,
+         "write %d pages again", PAGE_CNT);
+  msg ("read into misaligned buffer");
+  read_all (fds[0], dst + 1, sizeof src);
+  if (memcmp (src, dst + 1, sizeof src))
+    fail ("data read differs from data written");
+
+  close (fds[0]);
+  close (fds[1]);
+}
@@ -0,0 +1,15 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(pipe-pages) begin
+(pipe-pages) pipe
+(pipe-pages) write 4 pages
+(pipe-pages) read into aligned buffer
+(pipe-pages) write 4 pages again
+(pipe-pages) read into misaligned buffer
+(pipe-pages) end
+pipe-pages: exit(0)
+EOF
+pass;
@@ -0,0 +1,27 @@
+/* Writes a message into a pipe and reads it back out of the
+   other end. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void) 
+{
+  static const char message[] = "Through the pipe.";
+  char buffer[sizeof message];
+  int fds[2];
+
+  CHECK (pipe (fds) == 0, "pipe");
+  CHECK (fds[0] > 1 && fds[1] > 1 && fds[0] != fds[1],
+         "two new descriptors");
+  CHECK (write (fds[1], message, sizeof message) == sizeof message,
+         "write message");
+  CHECK (read (fds[0], buffer, sizeof buffer) == sizeof buffer,
+         "read message");
+  if (memcmp (buffer, message, sizeof message))
+    fail ("read \"%s\" instead of \"%s\"", buffer, message);
+  close (fds[0]);
+  close (fds[1]);
+}
@@ -0,0 +1,14 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(pipe-rw) begin
+(pipe-rw) pipe
+(pipe-rw) two new descriptors
+(pipe-rw) write message
+(pipe-rw) read message
+(pipe-rw) end
+pipe-rw: exit(0)
+EOF
+pass;
@@ -0,0 +1,34 @@
+/* Child process run by shm-share test.
+
+   Opens and maps the parent's segment, checks the parent's
+   message in each page and writes a reply next to it. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/vm/shm-share.h"
+#include "tests/lib.h"
+
+int
+main (void) 
+{
+  shmid_t id;
+  char *buf = (char *) SHM_SHARE_CHILD_ADDR;
+  int i;
+
+  test_name = "child-shm";
+
+  CHECK ((id = shm_open (SHM_SHARE_NAME, SHM_SHARE_SIZE)) != SHM_FAILED,
+         "shm_open \"%s\"", SHM_SHARE_NAME);
+  CHECK (shm_map (id, buf) == buf, "shm_map");
+  for (i = 0; i < 2; i++)
+    {
+      char *page = buf + i * PAGE_SIZE;
+      if (strcmp (page, shm_share_msg[i]))
+        fail ("message %d is \"%s\"", i, page);
+      strlcpy (page + SHM_SHARE_MSG_SIZE, shm_share_reply[i],
+               SHM_SHARE_MSG_SIZE);
+    }
+  msg ("messages arrived");
+
+  return 0;
+}
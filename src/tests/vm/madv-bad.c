@@ -0,0 +1,26 @@
+/* Passes madvise() ranges that are misaligned, not mapped, or
+   that run past the end of a mapped region, and advice it does
+   not know.  Each must fail. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+
+static char buf[PAGE_SIZE] __attribute__ ((aligned (PAGE_SIZE)));
+
+void
+test_main (void)
+{
+  CHECK (madvise (buf + 1, PAGE_SIZE - 1, MADV_NORMAL) == -1,
+         "try to madvise misaligned range");
+  CHECK (madvise ((void *) 0x10000000, PAGE_SIZE, MADV_WILLNEED) == -1,
+         "try to madvise unmapped range");
+  CHECK (madvise (buf, 0x10000000, MADV_DONTNEED) == -1,
+         "try to madvise range running past data segment");
+  CHECK (madvise (buf, PAGE_SIZE, (enum madvise_advice) 99) == -1,
+         "try to madvise with unknown advice");
+  CHECK (madvise (buf, PAGE_SIZE, MADV_NORMAL) == 0,
+         "madvise mapped range");
+}
@@ -0,0 +1,14 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(madv-bad) begin
+(madv-bad) try to madvise misaligned range
+(madv-bad) try to madvise unmapped range
+(madv-bad) try to madvise range running past data segment
+(madv-bad) try to madvise with unknown advice
+(madv-bad) madvise mapped range
+(madv-bad) end
+EOF
+pass;
@@ -0,0 +1,50 @@
+/* Dirties some zero-filled pages, then drops them with
+   MADV_DONTNEED.  They must read back as zeros, and still be
+   usable afterward.  Then drops them again while an aio_read()
+   into the first page is outstanding: that page must receive the
+   file's data, while the others are still dropped. */
+
+#include <syscall.h>
+#include "tests/vm/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define PAGE_CNT 8
+
+static char buf[PAGE_CNT * PAGE_SIZE] __attribute__ ((aligned (PAGE_SIZE)));
+
+void
+test_main (void)
+{
+  size_t size = sizeof sample - 1;
+  aioid_t id;
+  int handle;
+  size_t i;
+
+  msg ("dirty %d pages", PAGE_CNT);
+  for (i = 0; i < sizeof buf; i++)
+    buf[i] = i % 251 + 1;
+
+  CHECK (madvise (buf, sizeof buf, MADV_DONTNEED) == 0,
+         "madvise MADV_DONTNEED");
+  for (i = 0; i < sizeof buf; i++)
+    if (buf[i] != 0)
+      fail ("byte %zu is %d after MADV_DONTNEED", i, buf[i]);
+  msg ("pages read back as zeros");
+
+  buf[PAGE_SIZE] = 'x';
+  if (buf[PAGE_SIZE] != 'x')
+    fail ("page cannot be written again");
+
+  CHECK ((handle = open ("sample.txt")) > 1, "open \"sample.txt\"");
+  CHECK ((id = aio_read (handle, buf, size)) != AIO_FAILED,
+         "aio_read into first page");
+  CHECK (madvise (buf, sizeof buf, MADV_DONTNEED) == 0,
+         "madvise MADV_DONTNEED during aio_read");
+  CHECK (aio_wait (id) == (int) size, "wait for aio_read");
+  compare_bytes (buf, sample, size, 0, "sample.txt");
+  if (buf[PAGE_SIZE] != 0)
+    fail ("unpinned page kept its data");
+  close (handle);
+}
@@ -0,0 +1,16 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(madv-dontneed) begin
+(madv-dontneed) dirty 8 pages
+(madv-dontneed) madvise MADV_DONTNEED
+(madv-dontneed) pages read back as zeros
+(madv-dontneed) open "sample.txt"
+(madv-dontneed) aio_read into first page
+(madv-dontneed) madvise MADV_DONTNEED during aio_read
+(madv-dontneed) wait for aio_read
+(madv-dontneed) end
+EOF
+pass;
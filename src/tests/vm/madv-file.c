@@ -0,0 +1,56 @@
+/* Maps a file of several pages and reads it after MADV_WILLNEED,
+   which loads it ahead, then drops it and reads it again after
+   MADV_SEQUENTIAL, which reads ahead and lets go of the pages
+   behind.  The data must be right every time. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define PAGE_CNT 8
+#define FILE_SIZE (PAGE_CNT * PAGE_SIZE)
+
+static char data[FILE_SIZE];
+
+/* Checks the mapped file at ACTUAL against DATA. */
+static void
+verify (const char *actual)
+{
+  size_t i;
+
+  for (i = 0; i < FILE_SIZE; i++)
+    if (actual[i] != data[i])
+      fail ("byte %zu of mapping is %d, not %d", i, actual[i], data[i]);
+}
+
+void
+test_main (void)
+{
+  char *actual = (char *) 0x10000000;
+  int handle;
+  mapid_t map;
+  size_t i;
+
+  for (i = 0; i < FILE_SIZE; i++)
+    data[i] = i / PAGE_SIZE + i % 251;
+  CHECK (create ("data", FILE_SIZE), "create \"data\"");
+  CHECK ((handle = open ("data")) > 1, "open \"data\"");
+  CHECK (write (handle, data, FILE_SIZE) == FILE_SIZE, "write \"data\"");
+  CHECK ((map = mmap (handle, actual)) != MAP_FAILED, "mmap \"data\"");
+
+  CHECK (madvise (actual, FILE_SIZE, MADV_WILLNEED) == 0,
+         "madvise MADV_WILLNEED");
+  verify (actual);
+  msg ("verified after MADV_WILLNEED");
+
+  CHECK (madvise (actual, FILE_SIZE, MADV_DONTNEED) == 0,
+         "madvise MADV_DONTNEED");
+  CHECK (madvise (actual, FILE_SIZE, MADV_SEQUENTIAL) == 0,
+         "madvise MADV_SEQUENTIAL");
+  verify (actual);
+  msg ("verified after MADV_SEQUENTIAL");
+
+  munmap (map);
+  close (handle);
+}
@@ -0,0 +1,18 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(madv-file) begin
+(madv-file) create "data"
+(madv-file) open "data"
+(madv-file) write "data"
+(madv-file) mmap "data"
+(madv-file) madvise MADV_WILLNEED
+(madv-file) verified after MADV_WILLNEED
+(madv-file) madvise MADV_DONTNEED
+(madv-file) madvise MADV_SEQUENTIAL
+(madv-file) verified after MADV_SEQUENTIAL
+(madv-file) end
+EOF
+pass;
@@ -0,0 +1,38 @@
+/* Writes to every page of a 12 MB zero-filled array, run with
+   -hugepages, which maps each whole, aligned 4 MB of it with a
+   single large page.  Verifies the data, and that a large page
+   saved the faults of the 1024 pages it maps. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define HUGE_SIZE (4 * 1024 * 1024)
+#define BIG_SIZE (3 * HUGE_SIZE)
+
+static char big[BIG_SIZE];
+
+void
+test_main (void)
+{
+  struct vmstat before, after;
+  unsigned faults;
+  size_t i;
+
+  vmstat (&before);
+  msg ("write every page");
+  for (i = 0; i < BIG_SIZE; i += PAGE_SIZE)
+    big[i] = i / PAGE_SIZE;
+  vmstat (&after);
+
+  msg ("verify");
+  for (i = 0; i < BIG_SIZE; i++)
+    if (big[i] != (i % PAGE_SIZE == 0 ? (char) (i / PAGE_SIZE) : 0))
+      fail ("byte %zu holds %d", i, big[i]);
+
+  /* At least two whole, aligned 4 MB lie within the array */
+  faults = after.page_faults - before.page_faults;
+  if (faults >= (BIG_SIZE - HUGE_SIZE) / PAGE_SIZE)
+    fail ("%u page faults for %d pages", faults, BIG_SIZE / PAGE_SIZE);
+}
@@ -0,0 +1,11 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(page-wset-clock) begin
+(page-wset-clock) stream through cold pages
+(page-wset-clock) verify
+(page-wset-clock) end
+EOF
+pass;
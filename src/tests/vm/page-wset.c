@@ -0,0 +1,53 @@
+/* Keeps a small working set of pages busy while streaming through
+   a much larger buffer, then verifies both.  A replacement policy
+   that tracks the working set keeps the busy pages resident and
+   takes fewer page faults.  Also run as page-wset-clock under the
+   plain clock policy for comparison. */
+
+#include <string.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define HOT_PAGES 64
+#define COLD_PAGES 512
+#define ROUNDS 3
+
+/* Cold pages streamed through between two passes over the hot ones. */
+#define STRIDE 8
+
+static char hot[HOT_PAGES][PAGE_SIZE];
+static char cold[COLD_PAGES][PAGE_SIZE];
+
+/* Increments the first byte of every hot page. */
+static void
+touch_hot (void)
+{
+  size_t i;
+
+  for (i = 0; i < HOT_PAGES; i++)
+    hot[i][0]++;
+}
+
+void
+test_main (void)
+{
+  size_t i, round;
+
+  msg ("stream through cold pages");
+  for (round = 0; round < ROUNDS; round++)
+    for (i = 0; i < COLD_PAGES; i++)
+      {
+        cold[i][i % PAGE_SIZE] += i + 1;
+        if (i % STRIDE == STRIDE - 1)
+          touch_hot ();
+      }
+
+  msg ("verify");
+  for (i = 0; i < HOT_PAGES; i++)
+    if (hot[i][0] != (char) (ROUNDS * COLD_PAGES / STRIDE))
+      fail ("hot page %zu holds %d", i, hot[i][0]);
+  for (i = 0; i < COLD_PAGES; i++)
+    if (cold[i][i % PAGE_SIZE] != (char) (ROUNDS * (i + 1)))
+      fail ("cold page %zu holds %d", i, cold[i][i % PAGE_SIZE]);
+}
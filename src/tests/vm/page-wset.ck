@@ -0,0 +1,23 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(page-wset) begin
+(page-wset) stream through cold pages
+(page-wset) verify
+(page-wset) end
+EOF
+
+# Compare the page faults taken with those of the clock policy.
+sub page_faults {
+    my ($output) = @_;
+    foreach (read_text_file ($output)) {
+	return $1 if /^Exception: (\d+) page faults/;
+    }
+    return "?";
+}
+our ($test);
+my ($aging) = page_faults ("$test.output");
+my ($clock) = page_faults ("$test-clock.output");
+pass ("$aging page faults with aging, $clock with clock");
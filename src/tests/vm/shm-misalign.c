@@ -0,0 +1,17 @@
+/* Verifies that mapping shared memory at a misaligned address
+   is disallowed. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void) 
+{
+  shmid_t id;
+
+  CHECK ((id = shm_open ("misalign", 4096)) != SHM_FAILED,
+         "shm_open \"misalign\"");
+  CHECK (shm_map (id, (void *) 0x10001234) == NULL,
+         "try to shm_map at misaligned address");
+}
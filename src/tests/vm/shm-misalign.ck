@@ -0,0 +1,11 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(shm-misalign) begin
+(shm-misalign) shm_open "misalign"
+(shm-misalign) try to shm_map at misaligned address
+(shm-misalign) end
+EOF
+pass;
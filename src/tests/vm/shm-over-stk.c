@@ -0,0 +1,22 @@
+/* Verifies that shared memory cannot be mapped over the stack,
+   nor where the stack may still grow. */
+
+#include <stdint.h>
+#include <round.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void) 
+{
+  shmid_t id;
+  uintptr_t id_page = ROUND_DOWN ((uintptr_t) &id, 4096);
+
+  CHECK ((id = shm_open ("over-stk", 4096)) != SHM_FAILED,
+         "shm_open \"over-stk\"");
+  CHECK (shm_map (id, (void *) id_page) == NULL,
+         "try to shm_map over stack segment");
+  CHECK (shm_map (id, (void *) (id_page - 64 * 4096)) == NULL,
+         "try to shm_map below the stack");
+}
@@ -0,0 +1,12 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(shm-over-stk) begin
+(shm-over-stk) shm_open "over-stk"
+(shm-over-stk) try to shm_map over stack segment
+(shm-over-stk) try to shm_map below the stack
+(shm-over-stk) end
+EOF
+pass;
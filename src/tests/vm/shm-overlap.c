@@ -0,0 +1,30 @@
+/* Verifies that shared memory cannot be mapped over the
+   program's data or over another mapping. */
+
+#include <stdint.h>
+#include <round.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+static char data[4096];
+
+void
+test_main (void) 
+{
+  uintptr_t data_page = ROUND_DOWN ((uintptr_t) data, 4096);
+  char *addr = (char *) 0x10000000;
+  shmid_t first, second;
+
+  CHECK ((first = shm_open ("first", 2 * 4096)) != SHM_FAILED,
+         "shm_open \"first\"");
+  CHECK ((second = shm_open ("second", 2 * 4096)) != SHM_FAILED,
+         "shm_open \"second\"");
+  CHECK (shm_map (first, (void *) data_page) == NULL,
+         "try to shm_map over data segment");
+  CHECK (shm_map (first, addr) == addr, "shm_map \"first\"");
+  CHECK (shm_map (second, addr + 4096) == NULL,
+         "try to shm_map \"second\" over \"first\"");
+  CHECK (shm_map (second, addr - 4096) == NULL,
+         "try to shm_map \"second\" under \"first\"");
+}
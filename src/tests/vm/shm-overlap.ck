@@ -0,0 +1,15 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(shm-overlap) begin
+(shm-overlap) shm_open "first"
+(shm-overlap) shm_open "second"
+(shm-overlap) try to shm_map over data segment
+(shm-overlap) shm_map "first"
+(shm-overlap) try to shm_map "second" over "first"
+(shm-overlap) try to shm_map "second" under "first"
+(shm-overlap) end
+EOF
+pass;
@@ -0,0 +1,32 @@
+/* Creates a two-page shared memory segment and writes a message
+   into each page, then runs a child that maps the same segment
+   at another address, checks the messages and writes replies.
+   The parent must see the replies through its own mapping. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/vm/shm-share.h"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void) 
+{
+  shmid_t id;
+  char *buf = (char *) SHM_SHARE_PARENT_ADDR;
+
+  CHECK ((id = shm_open (SHM_SHARE_NAME, SHM_SHARE_SIZE)) != SHM_FAILED,
+         "shm_open \"%s\"", SHM_SHARE_NAME);
+  CHECK (shm_map (id, buf) == buf, "shm_map");
+  strlcpy (buf, shm_share_msg[0], SHM_SHARE_MSG_SIZE);
+  strlcpy (buf + PAGE_SIZE, shm_share_msg[1], SHM_SHARE_MSG_SIZE);
+
+  msg ("wait(exec()) = %d", wait (exec ("child-shm")));
+
+  if (strcmp (buf + SHM_SHARE_MSG_SIZE, shm_share_reply[0]))
+    fail ("first reply is \"%s\"", buf + SHM_SHARE_MSG_SIZE);
+  if (strcmp (buf + PAGE_SIZE + SHM_SHARE_MSG_SIZE, shm_share_reply[1]))
+    fail ("second reply is \"%s\"", buf + PAGE_SIZE + SHM_SHARE_MSG_SIZE);
+  msg ("replies arrived");
+  CHECK (shm_unmap (buf), "shm_unmap");
+}
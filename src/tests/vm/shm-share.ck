@@ -0,0 +1,19 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(shm-share) begin
+(shm-share) shm_open "shm-share"
+(shm-share) shm_map
+(child-shm) shm_open "shm-share"
+(child-shm) shm_map
+(child-shm) messages arrived
+child-shm: exit(0)
+(shm-share) wait(exec()) = 0
+(shm-share) replies arrived
+(shm-share) shm_unmap
+(shm-share) end
+shm-share: exit(0)
+EOF
+pass;
@@ -0,0 +1,19 @@
+#ifndef TESTS_VM_SHM_SHARE_H
+#define TESTS_VM_SHM_SHARE_H
+
+#define PAGE_SIZE 4096
+
+/* Segment shared by shm-share and its child, where each maps it,
+   and where in each page the messages and replies go. */
+#define SHM_SHARE_NAME "shm-share"
+#define SHM_SHARE_SIZE (2 * PAGE_SIZE)
+#define SHM_SHARE_PARENT_ADDR 0x10000000
+#define SHM_SHARE_CHILD_ADDR 0x20000000
+#define SHM_SHARE_MSG_SIZE 64
+
+static const char *shm_share_msg[] = { "from parent, page 0",
+                                       "from parent, page 1" };
+static const char *shm_share_reply[] = { "from child, page 0",
+                                         "from child, page 1" };
+
+#endif /* tests/vm/shm-share.h */
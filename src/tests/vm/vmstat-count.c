@@ -0,0 +1,60 @@
+/* Touches pages of BSS and then of a stack that must grow, and
+   checks that vmstat() counts them: the process's page faults
+   and resident pages, and the system's zero-fill faults, stack
+   faults and frames in use, must all go up. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define BSS_PAGES 16
+#define STACK_PAGES 32
+
+static volatile char bss[BSS_PAGES * PAGE_SIZE]
+  __attribute__ ((aligned (PAGE_SIZE)));
+
+/* Writes to every page of an object on the stack far larger than
+   the stack a process starts with. */
+static void NO_INLINE
+touch_stack (void)
+{
+  volatile char stk_obj[STACK_PAGES * PAGE_SIZE];
+  size_t i;
+
+  for (i = 0; i < sizeof stk_obj; i += PAGE_SIZE)
+    stk_obj[i] = 1;
+}
+
+void
+test_main (void)
+{
+  struct vmstat before, mid, after;
+  size_t i;
+
+  vmstat (&before);
+  msg ("touch %d BSS pages", BSS_PAGES);
+  for (i = 0; i < sizeof bss; i += PAGE_SIZE)
+    bss[i] = 1;
+  vmstat (&mid);
+
+  CHECK (mid.page_faults >= before.page_faults + BSS_PAGES,
+         "process page faults went up");
+  CHECK (mid.resident_pages >= before.resident_pages + BSS_PAGES,
+         "process resident pages went up");
+  CHECK (mid.zero_faults >= before.zero_faults + BSS_PAGES,
+         "system zero-fill faults went up");
+  CHECK (mid.frames_used >= before.frames_used + BSS_PAGES,
+         "system frames in use went up");
+
+  msg ("grow the stack by %d pages", STACK_PAGES);
+  touch_stack ();
+  vmstat (&after);
+
+  CHECK (after.page_faults > mid.page_faults,
+         "process page faults went up");
+  CHECK (after.resident_pages >= mid.resident_pages + STACK_PAGES,
+         "process resident pages went up");
+  CHECK (after.stack_faults > mid.stack_faults,
+         "system stack faults went up");
+}
@@ -0,0 +1,18 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(vmstat-count) begin
+(vmstat-count) touch 16 BSS pages
+(vmstat-count) process page faults went up
+(vmstat-count) process resident pages went up
+(vmstat-count) system zero-fill faults went up
+(vmstat-count) system frames in use went up
+(vmstat-count) grow the stack by 32 pages
+(vmstat-count) process page faults went up
+(vmstat-count) process resident pages went up
+(vmstat-count) system stack faults went up
+(vmstat-count) end
+EOF
+pass;
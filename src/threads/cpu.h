@@ -0,0 +1,96 @@
+#ifndef THREADS_CPU_H
+#define THREADS_CPU_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* CPUID leaf 1 feature bits in EDX.  See [IA32-v2a] "CPUID". */
+#define CPUID_PSE 0x00000008    /* 4 MB pages. */
+#define CPUID_SEP 0x00000800    /* SYSENTER and SYSEXIT. */
+#define CPUID_PGE 0x00002000    /* Global pages. */
+#define CPUID_FXSR 0x01000000   /* FXSAVE and FXRSTOR. */
+#define CPUID_SSE 0x02000000    /* SSE. */
+
+/* Control register 0 flags.  See [IA32-v3a] 2.5 "Control
+   Registers". */
+#define CR0_MP 0x00000002       /* Monitor coprocessor. */
+#define CR0_EM 0x00000004       /* Emulate the FPU. */
+#define CR0_TS 0x00000008       /* Task switched. */
+#define CR0_NE 0x00000020       /* Native FPU error reporting. */
+
+/* Control register 4 flags.  See [IA32-v3a] 2.5 "Control
+   Registers". */
+#define CR4_PSE 0x00000010      /* Page size extensions. */
+#define CR4_PGE 0x00000080      /* Global pages. */
+#define CR4_OSFXSR 0x00000200   /* FXSAVE, FXRSTOR and SSE. */
+#define CR4_OSXMMEXCPT 0x00000400 /* SIMD floating-point exceptions. */
+
+/* Model-specific registers.  See [IA32-v3b] appendix B. */
+#define MSR_SYSENTER_CS  0x174  /* SYSENTER target code segment. */
+#define MSR_SYSENTER_ESP 0x175  /* SYSENTER target stack pointer. */
+#define MSR_SYSENTER_EIP 0x176  /* SYSENTER target instruction. */
+
+/* Executes CPUID for LEAF and returns its EAX, EBX, ECX and EDX
+   outputs in the corresponding array elements of REGS. */
+static inline void
+cpuid (uint32_t leaf, uint32_t regs[4])
+{
+  /* See [IA32-v2a] "CPUID". */
+  asm volatile ("cpuid"
+                : "=a" (regs[0]), "=b" (regs[1]), "=c" (regs[2]), "=d" (regs[3])
+                : "a" (leaf));
+}
+
+/* Returns true if CPUID leaf 1 reports every feature in the EDX
+   mask FEATURES. */
+static inline bool
+cpu_has_features (uint32_t features)
+{
+  uint32_t regs[4];
+  cpuid (1, regs);
+  return (regs[3] & features) == features;
+}
+
+/* Returns the value of control register 0. */
+static inline uint32_t
+cr0_read (void)
+{
+  uint32_t cr0;
+  asm volatile ("movl %%cr0, %0" : "=r" (cr0));
+  return cr0;
+}
+
+/* Sets control register 0 to VALUE. */
+static inline void
+cr0_write (uint32_t value)
+{
+  asm volatile ("movl %0, %%cr0" : : "r" (value) : "memory");
+}
+
+/* Returns the value of control register 4. */
+static inline uint32_t
+cr4_read (void)
+{
+  uint32_t cr4;
+  asm volatile ("movl %%cr4, %0" : "=r" (cr4));
+  return cr4;
+}
+
+/* Sets control register 4 to VALUE. */
+static inline void
+cr4_write (uint32_t value)
+{
+  asm volatile ("movl %0, %%cr4" : : "r" (value) : "memory");
+}
+
+/* Writes VALUE to model-specific register MSR. */
+static inline void
+wrmsr (uint32_t msr, uint64_t value)
+{
+  /* See [IA32-v2b] "WRMSR". */
+  asm volatile ("wrmsr"
+                : : "c" (msr), "a" ((uint32_t) value),
+                    "d" ((uint32_t) (value >> 32)));
+}
+
+#endif /* threads/cpu.h */
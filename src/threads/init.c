@@ -15,6 +15,7 @@
 #include "devices/timer.h"
 #include "devices/vga.h"
 #include "devices/rtc.h"
+#include "threads/cpu.h"
 #include "threads/interrupt.h"
 #include "threads/io.h"
 #include "threads/loader.h"
@@ -22,10 +23,19 @@
 #include "threads/palloc.h"
 #include "threads/pte.h"
 #include "threads/thread.h"
+#include "vm/code.h"
 #include "vm/frame.h"
+#include "vm/page.h"
+#include "vm/shm.h"
+#include "vm/swap.h"
+#include "vm/vmstat.h"
+#include "vm/zswap.h"
 #ifdef USERPROG
 #include "userprog/process.h"
+#include "userprog/aio.h"
+#include "userprog/elfcache.h"
 #include "userprog/exception.h"
+#include "userprog/fpu.h"
 #include "userprog/gdt.h"
 #include "userprog/syscall.h"
 #include "userprog/tss.h"
@@ -55,6 +65,23 @@ static const char *swap_bdev_name;
 #endif
 #endif /* FILESYS */
 
+#ifdef VM
+/* -zswap: Pages of kernel memory for compressed swap, 0 if off. */
+static size_t zswap_pages;
+
+/* -vmstat: Print each process's memory use when it exits. */
+static bool vmstat_print_exit;
+
+/* -replace: Page replacement policy. */
+static enum frame_policy frame_policy = FRAME_AGING;
+
+/* -stack: Largest stack of a user process, in bytes. */
+static size_t stack_max = STACK_SIZE;
+
+/* -hugepages: Map large zero-filled user regions with 4 MB pages? */
+static bool huge_pages;
+#endif
+
 /* -ul: Maximum number of pages to put into palloc's user pool. */
 static size_t user_page_limit = SIZE_MAX;
 
@@ -99,7 +126,12 @@ main (void)
   palloc_init (user_page_limit);
   malloc_init ();
   paging_init ();
-  frame_init ();
+#ifdef VM
+  frame_init (frame_policy);
+  page_zero_init ();
+  page_stack_init (stack_max);
+  page_huge_init (huge_pages && cpu_has_features (CPUID_PSE));
+#endif
 
   /* Segmentation. */
 #ifdef USERPROG
@@ -114,6 +146,7 @@ main (void)
   input_init ();
 #ifdef USERPROG
   exception_init ();
+  fpu_init ();
   syscall_init ();
 #endif
 
@@ -130,6 +163,17 @@ main (void)
 #endif
 
   swap_init ();
+#ifdef VM
+  zswap_init (zswap_pages, swap_slot_cnt ());
+  vmstat_init (vmstat_print_exit);
+#endif
+  frame_pageout_init ();
+  shm_init ();
+  code_init ();
+#ifdef USERPROG
+  aio_init ();
+  elf_cache_init ();
+#endif
 
   printf ("Boot complete.\n");
   
@@ -164,6 +208,11 @@ paging_init (void)
   uint32_t *pd, *pt;
   size_t page;
   extern char _start, _end_kernel_text;
+  bool pse = cpu_has_features (CPUID_PSE);
+
+  /* Allow 4 MB pages in the page directory. */
+  if (pse)
+    cr4_write (cr4_read () | CR4_PSE);
 
   pd = init_page_dir = palloc_get_page (PAL_ASSERT | PAL_ZERO);
   pt = NULL;
@@ -175,13 +224,24 @@ paging_init (void)
       size_t pte_idx = pt_no (vaddr);
       bool in_kernel_text = &_start <= vaddr && vaddr < &_end_kernel_text;
 
+      /* Map each whole 4 MB of RAM that holds no kernel code, which
+         must stay read-only, with a single large page.  That takes
+         one TLB entry instead of 1024, and no page table. */
+      if (pse && pte_idx == 0 && init_ram_pages - page >= PTSPAN / PGSIZE
+          && (vaddr + PTSPAN <= &_start || vaddr >= &_end_kernel_text))
+        {
+          pd[pde_idx] = pde_create_large (vaddr, true) | PTE_G;
+          page += PTSPAN / PGSIZE - 1;
+          continue;
+        }
+
       if (pd[pde_idx] == 0)
         {
           pt = palloc_get_page (PAL_ASSERT | PAL_ZERO);
           pd[pde_idx] = pde_create (pt);
         }
 
-      pt[pte_idx] = pte_create_kernel (vaddr, !in_kernel_text);
+      pt[pte_idx] = pte_create_kernel (vaddr, !in_kernel_text) | PTE_G;
     }
 
   /* Store the physical address of the page directory into CR3
@@ -190,6 +250,13 @@ paging_init (void)
      to/from Control Registers" and [IA32-v3a] 3.7.5 "Base Address
      of the Page Directory". */
   asm volatile ("movl %0, %%cr3" : : "r" (vtop (init_page_dir)));
+
+  /* The kernel mappings are the same in every page directory and
+     never change, so keep them in the TLB across address space
+     switches.  See [IA32-v3a] 3.12 "Translation Lookaside Buffers
+     (TLBs)". */
+  if (cpu_has_features (CPUID_PGE))
+    cr4_write (cr4_read () | CR4_PGE);
 }
 
 /* Breaks the kernel command line into words and returns them as
@@ -261,6 +328,29 @@ parse_options (char **argv)
 #ifdef USERPROG
       else if (!strcmp (name, "-ul"))
         user_page_limit = atoi (value);
+#endif
+#ifdef VM
+      else if (!strcmp (name, "-zswap"))
+        zswap_pages = value != NULL ? (size_t) atoi (value) : 256;
+      else if (!strcmp (name, "-vmstat"))
+        vmstat_print_exit = true;
+      else if (!strcmp (name, "-stack"))
+        {
+          if (value == NULL || atoi (value) <= 0)
+            PANIC ("-stack needs a size in kB (use -h for help)");
+          stack_max = (size_t) atoi (value) * 1024;
+        }
+      else if (!strcmp (name, "-hugepages"))
+        huge_pages = true;
+      else if (!strcmp (name, "-replace"))
+        {
+          if (value != NULL && !strcmp (value, "clock"))
+            frame_policy = FRAME_CLOCK;
+          else if (value != NULL && !strcmp (value, "aging"))
+            frame_policy = FRAME_AGING;
+          else
+            PANIC ("unknown page replacement policy (use -h for help)");
+        }
 #endif
       else
         PANIC ("unknown option `%s' (use -h for help)", name);
@@ -382,6 +472,16 @@ usage (void)
           "  -rs=SEED           Set random number seed to SEED.\n"
 #ifdef USERPROG
           "  -ul=COUNT          Limit user memory to COUNT pages.\n"
+#endif
+#ifdef VM
+          "  -zswap[=COUNT]     Keep swapped pages compressed in COUNT pages\n"
+          "                     of kernel memory (default 256) when possible.\n"
+          "  -vmstat            Print each process's memory use at exit.\n"
+          "  -stack=KB          Let user stacks grow to KB kB (default 8192).\n"
+          "  -hugepages         Map each aligned 4 MB of large zero-filled\n"
+          "                     user data with one pinned 4 MB page.\n"
+          "  -replace=POLICY    Evict pages by POLICY, \"aging\" (default) or\n"
+          "                     \"clock\".\n"
 #endif
           );
   shutdown_power_off ();
@@ -2,15 +2,25 @@
 #include "threads/malloc.h"
 #include "threads/synch.h"
 #include "threads/thread.h"
+#include <string.h>
 
 /* Initialize producer-consumer instance. */
 void
 procon_init (struct procon *pc, unsigned int buffer_size)
+{
+  if (!procon_try_init (pc, buffer_size))
+    PANIC ("out of memory allocating buffer");
+}
+
+/* Initialize producer-consumer instance.  Returns false if the
+   buffer cannot be allocated. */
+bool
+procon_try_init (struct procon *pc, unsigned int buffer_size)
 {
   // Allocate buffer
   pc->buffer = (char *) malloc (buffer_size);
   if (pc->buffer == NULL)
-    PANIC ("out of memory allocating buffer");
+    return false;
 
   // Initialize synchronization primitives
   lock_init (&pc->lock);
@@ -22,6 +32,7 @@ procon_init (struct procon *pc, unsigned int buffer_size)
   pc->in = 0;
   pc->out = 0;
   pc->current = 0;
+  return true;
 }
 
 /* Put a character into the bounded buffer. Wait if the buffer is full. */
@@ -70,3 +81,69 @@ procon_consume (struct procon *pc)
   lock_release(&pc->lock);
   return c;
 }
+
+/* Free the buffer of a producer-consumer instance. */
+void
+procon_destroy (struct procon *pc)
+{
+  free (pc->buffer);
+  pc->buffer = NULL;
+}
+
+/* Copy up to SIZE bytes from SRC into the buffer, without waiting.
+   Returns the number of bytes copied, which is less than SIZE if the
+   buffer fills up.  The caller must hold the lock and signal the
+   not_empty condition if it copied anything. */
+size_t
+procon_put (struct procon *pc, const void *src_, size_t size)
+{
+  const char *src = src_;
+  size_t copied = 0;
+
+  ASSERT (lock_held_by_current_thread (&pc->lock));
+
+  // Copy in at most two runs, up to the end of the buffer and from its start
+  while (copied < size && pc->current < pc->size)
+  {
+    size_t run = pc->size - pc->in;
+    if (run > pc->size - pc->current)
+      run = pc->size - pc->current;
+    if (run > size - copied)
+      run = size - copied;
+
+    memcpy (pc->buffer + pc->in, src + copied, run);
+    pc->in = (pc->in + run) % pc->size;
+    pc->current += run;
+    copied += run;
+  }
+  return copied;
+}
+
+/* Copy up to SIZE bytes out of the buffer into DST, without waiting.
+   Returns the number of bytes copied, which is 0 if the buffer is
+   empty.  The caller must hold the lock and signal the not_full
+   condition if it copied anything. */
+size_t
+procon_get (struct procon *pc, void *dst_, size_t size)
+{
+  char *dst = dst_;
+  size_t copied = 0;
+
+  ASSERT (lock_held_by_current_thread (&pc->lock));
+
+  // Copy out in at most two runs, up to the end of the buffer and from its start
+  while (copied < size && pc->current > 0)
+  {
+    size_t run = pc->size - pc->out;
+    if (run > pc->current)
+      run = pc->current;
+    if (run > size - copied)
+      run = size - copied;
+
+    memcpy (dst + copied, pc->buffer + pc->out, run);
+    pc->out = (pc->out + run) % pc->size;
+    pc->current -= run;
+    copied += run;
+  }
+  return copied;
+}
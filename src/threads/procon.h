@@ -2,6 +2,7 @@
 #define THREADS_PROCON_H
 
 #include "threads/synch.h"
+#include <stddef.h>
 #include <stdint.h>
 
 /* State for producer-consumer mechanism */
@@ -20,7 +21,13 @@ struct procon
 void print_procon (struct procon *pc);
 
 void procon_init (struct procon *, unsigned buffer_size);
+bool procon_try_init (struct procon *, unsigned buffer_size);
+void procon_destroy (struct procon *);
 void procon_produce (struct procon *, char c);
 char procon_consume (struct procon *);
 
+/* Multi-byte transfers.  The caller must hold PC's lock. */
+size_t procon_put (struct procon *, const void *, size_t size);
+size_t procon_get (struct procon *, void *, size_t size);
+
 #endif /* threads/procon.h */
@@ -66,6 +66,8 @@ static inline uintptr_t pd_no (const void *va) {
 #define PTE_U 0x4               /* 1=user/kernel, 0=kernel only. */
 #define PTE_A 0x20              /* 1=accessed, 0=not acccessed. */
 #define PTE_D 0x40              /* 1=dirty, 0=not dirty (PTEs only). */
+#define PTE_PS 0x80             /* 1=4 MB page, 0=page table (PDEs only). */
+#define PTE_G 0x100             /* 1=global, kept in the TLB across CR3 loads. */
 
 /* Returns a PDE that points to page table PT. */
 static inline uint32_t pde_create (uint32_t *pt) {
@@ -73,10 +75,35 @@ static inline uint32_t pde_create (uint32_t *pt) {
   return vtop (pt) | PTE_U | PTE_P | PTE_W;
 }
 
+/* Returns a PDE that maps the 4 MB of physical memory starting at
+   PAGE, which must be 4 MB aligned, as one large page.  The memory
+   is readable, writable as well if WRITABLE is true, and usable
+   only by ring 0 code.  Requires CR4_PSE.  See [IA32-v3a] 3.7.3
+   "Mixing 4-KByte and 4-MByte Pages". */
+static inline uint32_t pde_create_large (void *page, bool writable) {
+  ASSERT (vtop (page) % PTSPAN == 0);
+  return vtop (page) | PTE_PS | PTE_P | (writable ? PTE_W : 0);
+}
+
+/* Returns a PDE that maps the 4 MB at PAGE like
+   pde_create_large(), but usable by user code as well. */
+static inline uint32_t pde_create_large_user (void *page, bool writable) {
+  return pde_create_large (page, writable) | PTE_U;
+}
+
+/* Returns a kernel virtual address for the 4 MB of physical memory
+   that PDE, which must be "present" and map a large page, maps. */
+static inline void *pde_get_large_page (uint32_t pde) {
+  ASSERT (pde & PTE_P);
+  ASSERT (pde & PTE_PS);
+  return ptov (pde & ~(uint32_t) (PTSPAN - 1));
+}
+
 /* Returns a pointer to the page table that page directory entry
-   PDE, which must "present", points to. */
+   PDE, which must "present" and not map a large page, points to. */
 static inline uint32_t *pde_get_pt (uint32_t pde) {
   ASSERT (pde & PTE_P);
+  ASSERT (!(pde & PTE_PS));
   return ptov (pde & PTE_ADDR);
 }
 
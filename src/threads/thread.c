@@ -17,6 +17,9 @@
 #ifdef FILESYS
 #include "filesys/directory.h"
 #endif
+#ifdef VM
+#include "vm/frame.h"
+#endif
 
 /* Random value for struct thread's `magic' member.
    Used to detect stack overflow.  See the big comment at the top
@@ -33,6 +36,12 @@ static struct list all_list;
 
 static struct list sleep_list;
 
+/* Process structures not in use.  They are carved out of whole
+   pages, which are kept once allocated, and taken and returned
+   with interrupts off, because processes are freed with
+   interrupts off. */
+static struct list free_processes;
+
 /* Idle thread. */
 static struct thread *idle_thread;
 
@@ -127,6 +136,7 @@ thread_init (void)
   list_init (&ready_list);
   list_init (&all_list);
   list_init (&sleep_list);
+  list_init (&free_processes);
 
   /* Set up a thread structure for the running thread. */
   initial_thread = running_thread ();
@@ -169,6 +179,11 @@ thread_tick (void)
   else
     kernel_ticks++;
 
+#ifdef VM
+  /* Age the frames now and then. */
+  frame_tick ();
+#endif
+
   /* Enforce preemption. */
   if (++thread_ticks >= TIME_SLICE)
     intr_yield_on_return ();
@@ -182,15 +197,42 @@ thread_print_stats (void)
           idle_ticks, kernel_ticks, user_ticks);
 }
 
+/* Adds the process structures that fit in a new page to
+   free_processes.  Returns false if no page is free. */
+static bool
+refill_processes (void)
+{
+  struct process *p = palloc_get_page (0);
+  enum intr_level old_level;
+  size_t i;
+
+  if (p == NULL)
+    return false;
+  old_level = intr_disable ();
+  for (i = 0; i < PGSIZE / sizeof *p; i++)
+    list_push_back (&free_processes, &p[i].elem);
+  intr_set_level (old_level);
+  return true;
+}
+
 /* Creates a new process that is connected to the thread */
 struct process *
 create_process (struct thread *t)
 {
-  struct process *p = palloc_get_page (0);
-  if (p == NULL)
+  enum intr_level old_level;
+  struct process *p;
+
+  old_level = intr_disable ();
+  while (list_empty (&free_processes))
     {
-      return NULL;
+      intr_set_level (old_level);
+      if (!refill_processes ())
+        return NULL;
+      old_level = intr_disable ();
     }
+  p = list_entry (list_pop_front (&free_processes), struct process, elem);
+  intr_set_level (old_level);
+
   p->pid = t->tid;
   p->thread = t;
   p->is_waiting = false;
@@ -200,6 +242,16 @@ create_process (struct thread *t)
   return p;
 }
 
+/* Returns process P, created by create_process(), to
+   free_processes. */
+void
+free_process (struct process *p)
+{
+  enum intr_level old_level = intr_disable ();
+  list_push_front (&free_processes, &p->elem);
+  intr_set_level (old_level);
+}
+
 /* Creates a new kernel thread named NAME with the given initial
    PRIORITY, which executes FUNCTION passing AUX as the argument,
    and adds it to the ready queue.  Returns the thread identifier
@@ -698,6 +750,9 @@ init_thread (struct thread *t, const char *name, int priority)
 
   list_init (&t->donations);
   list_init (&t->childrens);
+  list_init (&t->aio_requests);
+  list_init (&t->shm_refs);
+  list_init (&t->mmaps);
 
   sema_init (&t->wait_for_load, 0);
   sema_init (&t->wait_for_exit, 0);
@@ -31,8 +31,6 @@ typedef int pid_t;
 #define PRI_DEFAULT 31                  /* Default priority. */
 #define PRI_MAX 63                      /* Highest priority. */
 
-#define MAX_OPEN_FILES 128     /* Maximum number of files per thread*/
-
 /* A kernel thread or user process.
 
    Each thread structure is stored in its own 4 kB page.  The
@@ -113,19 +111,33 @@ struct thread
 #ifdef USERPROG
     /* Owned by userprog/process.c. */
     uint32_t *pagedir;                  /* Page directory. */
+    void *fpu;                          /* FPU save area, NULL until used. */
 
      /* New elements */
     int exit_status;                    /* Exit status of the thread */    
-    struct file ** fd_table;            /* Open files of thread */   
+    struct fd_table *fd_table;          /* Open files of thread */
     struct list childrens;              /* List of child threads */
     struct file *executable;            /* Executable file of the thread */
     struct process *process;            /* Process of the thread */
     struct semaphore wait_for_exit;     /* Wait for a thread to exit*/
     struct semaphore wait_for_load;     /* Wait for a thread to load */
+    struct list aio_requests;           /* Outstanding asynchronous I/O */
+    int aio_next_id;                    /* Id of the next aio request */
+    struct list shm_refs;               /* Shared memory opened or mapped */
+    struct list mmaps;                  /* Memory-mapped files */
+    int mmap_next_id;                   /* Id of the next mapping */
 
 #endif
 
    struct hash *supl_pt;                /* Supplemental page table */
+   struct vma *vmas;                    /* Regions, sorted by address */
+   size_t vma_cnt;                      /* Number of regions */
+   size_t vma_cap;                      /* Room for regions in vmas */
+   unsigned fault_around;               /* Pages to prefault on each side */
+   void *fault_around_lo;               /* Start of last prefaulted range */
+   void *fault_around_hi;               /* End of last prefaulted range */
+   size_t stack_max;                    /* Largest stack, in bytes */
+   unsigned page_faults;                /* Page faults taken */
    void* code_segment;                 /* Offset of end of code segment */
 
    struct dir *cwd;                     /* Current working directory */
@@ -159,6 +171,9 @@ bool thread_exists_higher_priority(void);
 void thread_init (void);
 void thread_start (void);
 
+struct process *create_process (struct thread *);
+void free_process (struct process *);
+
 void thread_tick (void);
 void thread_print_stats (void);
 
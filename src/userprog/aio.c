@@ -0,0 +1,280 @@
+#include "userprog/aio.h"
+#include <debug.h>
+#include <list.h>
+#include <stdint.h>
+#include "filesys/file.h"
+#include "filesys/off_t.h"
+#include "filesys/rwlock.h"
+#include "threads/malloc.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+#include "userprog/pagedir.h"
+#include "userprog/syscall.h"
+#include "vm/page.h"
+
+/* Number of kernel threads serving asynchronous requests. */
+#define AIO_WORKER_CNT 4
+
+/* Maximum number of unfinished requests per process. */
+#define AIO_MAX_PENDING 64
+
+/* An asynchronous I/O request.
+   Created by the submitting process, executed by one of the
+   worker threads and released by aio_wait() or aio_exit(). */
+struct aio_request
+  {
+    int id;                       /* Request identifier. */
+    enum aio_type type;           /* Read or write. */
+    struct thread *owner;         /* Submitting process. */
+    struct file *file;            /* Private handle on the file. */
+    off_t ofs;                    /* File offset of the transfer. */
+    uint8_t *buffer;              /* User buffer, pinned while queued. */
+    unsigned size;                /* Bytes to transfer. */
+    int result;                   /* Bytes transferred or -1. */
+    bool done;                    /* True once a worker finished it. */
+    struct semaphore done_sema;   /* Upped when the request finishes. */
+    struct list_elem elem;        /* Element in owner's aio_requests. */
+    struct list_elem queue_elem;  /* Element in aio_queue. */
+  };
+
+/* Requests waiting for a worker thread. */
+static struct list aio_queue;
+static struct lock aio_queue_lock;
+static struct condition aio_queue_available;
+
+static void aio_worker (void *aux UNUSED);
+
+/* Initializes the request queue and starts the worker pool. */
+void
+aio_init (void)
+{
+  int i;
+
+  list_init (&aio_queue);
+  lock_init (&aio_queue_lock);
+  cond_init (&aio_queue_available);
+
+  for (i = 0; i < AIO_WORKER_CNT; i++)
+    thread_create ("aio_worker", PRI_DEFAULT, aio_worker, NULL);
+}
+
+/* Returns the current process's request with the given id, or NULL if
+   there is none. */
+static struct aio_request *
+aio_lookup (int aioid)
+{
+  struct thread *cur = thread_current ();
+  struct list_elem *e;
+
+  for (e = list_begin (&cur->aio_requests); e != list_end (&cur->aio_requests);
+       e = list_next (e))
+    {
+      struct aio_request *r = list_entry (e, struct aio_request, elem);
+      if (r->id == aioid)
+        return r;
+    }
+  return NULL;
+}
+
+/* Queues a transfer of SIZE bytes between BUFFER and the file open as FD,
+   starting at the file's current position, which is advanced past the
+   transfer right away.  BUFFER's pages are loaded and pinned before the
+   request is queued, and stay pinned until it is collected.  Exits the
+   process if BUFFER is not valid.
+   Returns the request's id, or -1 if it cannot be queued. */
+int
+aio_submit (enum aio_type type, int fd, void *buffer, unsigned size)
+{
+  struct thread *cur = thread_current ();
+  struct lock *fs_lock = get_filesys_lock ();
+  struct aio_request *r;
+  struct file *file;
+
+  if (list_size (&cur->aio_requests) >= AIO_MAX_PENDING)
+    return -1;
+
+  /* Load and pin together, so that the workers never find a page of
+     BUFFER evicted. */
+  page_pin_pages (buffer, size, type == AIO_READ);
+  r = malloc (sizeof *r);
+  if (r == NULL)
+    goto fail;
+
+  /* Take a private handle so that closing FD does not pull the file out
+     from under a worker, and reserve the byte range now so requests on
+     the same descriptor do not overlap. */
+  lock_acquire (fs_lock);
+  file = get_file (fd);
+  if (file == NULL || (type == AIO_WRITE && file_is_dir (file)))
+    {
+      lock_release (fs_lock);
+      free (r);
+      goto fail;
+    }
+  r->file = file_reopen (file);
+  r->ofs = file_tell (file);
+  if (type == AIO_READ)
+    {
+      off_t left = file_length (file) - r->ofs;
+      if (left < 0)
+        left = 0;
+      file_seek (file, r->ofs + ((off_t) size < left ? (off_t) size : left));
+    }
+  else
+    file_seek (file, r->ofs + size);
+  lock_release (fs_lock);
+
+  if (r->file == NULL)
+    {
+      free (r);
+      goto fail;
+    }
+
+  r->id = cur->aio_next_id++;
+  r->type = type;
+  r->owner = cur;
+  r->buffer = buffer;
+  r->size = size;
+  r->result = -1;
+  r->done = false;
+  sema_init (&r->done_sema, 0);
+  list_push_back (&cur->aio_requests, &r->elem);
+
+  lock_acquire (&aio_queue_lock);
+  list_push_back (&aio_queue, &r->queue_elem);
+  cond_signal (&aio_queue_available, &aio_queue_lock);
+  lock_release (&aio_queue_lock);
+
+  return r->id;
+
+fail:
+  page_unpin_pages (buffer, size);
+  return -1;
+}
+
+/* Moves the data of request R page by page through the kernel alias of
+   the owner's pinned frames.  Returns the number of bytes transferred. */
+static int
+aio_transfer (struct aio_request *r)
+{
+  struct rw_lock *rw_lock = get_rw_lock ();
+  uint8_t *uaddr = r->buffer;
+  unsigned left = r->size;
+  off_t ofs = r->ofs;
+  int total = 0;
+
+  if (r->type == AIO_READ)
+    rwlock_acquire_read (rw_lock);
+  else
+    rwlock_acquire_write (rw_lock);
+
+  while (left > 0)
+    {
+      size_t page_left = PGSIZE - pg_ofs (uaddr);
+      size_t chunk = left < page_left ? left : page_left;
+      uint8_t *kaddr = pagedir_get_page (r->owner->pagedir, uaddr);
+      off_t cnt;
+
+      if (kaddr == NULL)
+        {
+          total = -1;
+          break;
+        }
+
+      if (r->type == AIO_READ)
+        {
+          cnt = file_read_at (r->file, kaddr, chunk, ofs);
+          /* The data went in through the kernel alias, so the user
+             mapping does not know the page changed. */
+          if (cnt > 0)
+            pagedir_set_dirty (r->owner->pagedir, uaddr, true);
+        }
+      else
+        cnt = file_write_at (r->file, kaddr, chunk, ofs);
+
+      total += cnt;
+      if ((size_t) cnt != chunk)
+        break;
+      uaddr += chunk;
+      ofs += chunk;
+      left -= chunk;
+    }
+
+  if (r->type == AIO_READ)
+    rwlock_release_read (rw_lock);
+  else
+    rwlock_release_write (rw_lock);
+  return total;
+}
+
+/* Worker thread: executes queued requests one at a time. */
+static void
+aio_worker (void *aux UNUSED)
+{
+  for (;;)
+    {
+      struct aio_request *r;
+
+      lock_acquire (&aio_queue_lock);
+      while (list_empty (&aio_queue))
+        cond_wait (&aio_queue_available, &aio_queue_lock);
+      r = list_entry (list_pop_front (&aio_queue), struct aio_request,
+                      queue_elem);
+      lock_release (&aio_queue_lock);
+
+      r->result = aio_transfer (r);
+      r->done = true;
+      sema_up (&r->done_sema);
+    }
+}
+
+/* Blocks until request R is finished, then unpins its buffer and
+   frees it.  Returns the request's result. */
+static int
+aio_collect (struct aio_request *r)
+{
+  int result;
+
+  sema_down (&r->done_sema);
+  result = r->result;
+  page_unpin_pages (r->buffer, r->size);
+  list_remove (&r->elem);
+  file_close (r->file);
+  free (r);
+  return result;
+}
+
+/* Waits for request AIOID of the current process to finish and releases
+   it.  Returns the number of bytes transferred, or -1 if AIOID is not an
+   outstanding request or the transfer failed. */
+int
+aio_wait (int aioid)
+{
+  struct aio_request *r = aio_lookup (aioid);
+  return r != NULL ? aio_collect (r) : -1;
+}
+
+/* Returns 1 if request AIOID has finished and can be collected with
+   aio_wait() without blocking, 0 if it is still in flight, and -1 if
+   AIOID is not an outstanding request. */
+int
+aio_poll (int aioid)
+{
+  struct aio_request *r = aio_lookup (aioid);
+  if (r == NULL)
+    return -1;
+  return r->done ? 1 : 0;
+}
+
+/* Waits for and releases every request of the exiting process, so that
+   no worker touches its frames after they are freed. */
+void
+aio_exit (void)
+{
+  struct thread *cur = thread_current ();
+
+  while (!list_empty (&cur->aio_requests))
+    aio_collect (list_entry (list_front (&cur->aio_requests),
+                             struct aio_request, elem));
+}
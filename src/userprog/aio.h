@@ -0,0 +1,19 @@
+#ifndef USERPROG_AIO_H
+#define USERPROG_AIO_H
+
+#include <stdbool.h>
+
+/* Direction of an asynchronous request. */
+enum aio_type
+  {
+    AIO_READ,                   /* Read from the file into the buffer. */
+    AIO_WRITE                   /* Write the buffer into the file. */
+  };
+
+void aio_init (void);
+int aio_submit (enum aio_type type, int fd, void *buffer, unsigned size);
+int aio_wait (int aioid);
+int aio_poll (int aioid);
+void aio_exit (void);
+
+#endif /* userprog/aio.h */
@@ -0,0 +1,178 @@
+#include "userprog/elfcache.h"
+#include <list.h>
+#include "filesys/inode.h"
+#include "threads/malloc.h"
+#include "threads/synch.h"
+#include "userprog/syscall.h"
+
+/* A kept layout.  The entry holds INODE open, so that the inode
+   stays the same object, and is stale once the inode has been
+   written to since the layout was read, or removed. */
+struct elf_cache_entry
+  {
+    struct list_elem elem;      /* Element in elf_cache. */
+    struct inode *inode;        /* Executable. */
+    unsigned write_cnt;         /* Its write count when read. */
+    struct elf_image image;     /* Its layout. */
+  };
+
+/* Kept layouts, most recently used first, and their lock. */
+static struct list elf_cache;
+static struct lock elf_cache_lock;
+static size_t elf_cache_cnt;
+
+/* Initializes the executable layout cache. */
+void
+elf_cache_init (void)
+{
+  list_init (&elf_cache);
+  lock_init (&elf_cache_lock);
+}
+
+/* Removes entry E from the cache.  Caller holds elf_cache_lock and
+   frees E afterward with elf_cache_free(). */
+static void
+elf_cache_remove (struct elf_cache_entry *e)
+{
+  list_remove (&e->elem);
+  elf_cache_cnt--;
+}
+
+/* Frees entry E, which is no longer in the cache.  Closing its
+   inode may free the sectors of a removed executable, so this takes
+   the file system lock. */
+static void
+elf_cache_free (struct elf_cache_entry *e)
+{
+  if (e != NULL)
+    {
+      struct lock *fs_lock = get_filesys_lock ();
+      lock_acquire (fs_lock);
+      inode_close (e->inode);
+      lock_release (fs_lock);
+      free (e);
+    }
+}
+
+/* Returns true if entry E no longer describes its executable. */
+static bool
+elf_cache_is_stale (const struct elf_cache_entry *e)
+{
+  return (e->write_cnt != inode_get_write_cnt (e->inode)
+          || inode_is_removed (e->inode));
+}
+
+/* Returns the entry for INODE, or a null pointer.  Drops the entry
+   and returns a null pointer if it is stale, storing it in *STALE
+   for the caller to free.  Caller holds elf_cache_lock. */
+static struct elf_cache_entry *
+elf_cache_find (struct inode *inode, struct elf_cache_entry **stale)
+{
+  struct list_elem *le;
+
+  for (le = list_begin (&elf_cache); le != list_end (&elf_cache);
+       le = list_next (le))
+    {
+      struct elf_cache_entry *e = list_entry (le, struct elf_cache_entry,
+                                              elem);
+      if (e->inode != inode)
+        continue;
+      if (elf_cache_is_stale (e))
+        {
+          elf_cache_remove (e);
+          *stale = e;
+          return NULL;
+        }
+      return e;
+    }
+  return NULL;
+}
+
+/* Copies the kept layout of the executable INODE into *IMAGE.
+   Returns false if there is none, or if INODE was written to since
+   it was kept. */
+bool
+elf_cache_lookup (struct inode *inode, struct elf_image *image)
+{
+  struct elf_cache_entry *e, *stale = NULL;
+
+  lock_acquire (&elf_cache_lock);
+  e = elf_cache_find (inode, &stale);
+  if (e != NULL)
+    {
+      list_remove (&e->elem);
+      list_push_front (&elf_cache, &e->elem);
+      *image = e->image;
+    }
+  lock_release (&elf_cache_lock);
+
+  elf_cache_free (stale);
+  return e != NULL;
+}
+
+/* Keeps IMAGE as the layout of the executable INODE, read when
+   inode_get_write_cnt() returned WRITE_CNT, making room by dropping
+   the least recently used layout.  Does nothing if memory runs
+   out. */
+void
+elf_cache_insert (struct inode *inode, unsigned write_cnt,
+                  const struct elf_image *image)
+{
+  struct elf_cache_entry *e = malloc (sizeof *e);
+  struct elf_cache_entry *old, *victim = NULL;
+
+  if (e == NULL)
+    return;
+  e->inode = inode_reopen (inode);
+  e->write_cnt = write_cnt;
+  e->image = *image;
+
+  lock_acquire (&elf_cache_lock);
+  old = elf_cache_find (inode, &victim);
+  if (old != NULL)
+    {
+      /* Someone else kept it meanwhile. */
+      lock_release (&elf_cache_lock);
+      elf_cache_free (e);
+      return;
+    }
+  if (victim == NULL && elf_cache_cnt >= ELF_CACHE_SIZE)
+    {
+      victim = list_entry (list_back (&elf_cache), struct elf_cache_entry,
+                           elem);
+      elf_cache_remove (victim);
+    }
+  list_push_front (&elf_cache, &e->elem);
+  elf_cache_cnt++;
+  lock_release (&elf_cache_lock);
+
+  elf_cache_free (victim);
+}
+
+/* Drops the layouts of removed executables, so that their inodes
+   are closed and their sectors freed. */
+void
+elf_cache_drop_removed (void)
+{
+  struct list stale;
+  struct list_elem *le;
+
+  list_init (&stale);
+  lock_acquire (&elf_cache_lock);
+  for (le = list_begin (&elf_cache); le != list_end (&elf_cache); )
+    {
+      struct elf_cache_entry *e = list_entry (le, struct elf_cache_entry,
+                                              elem);
+      le = list_next (le);
+      if (inode_is_removed (e->inode))
+        {
+          elf_cache_remove (e);
+          list_push_back (&stale, &e->elem);
+        }
+    }
+  lock_release (&elf_cache_lock);
+
+  while (!list_empty (&stale))
+    elf_cache_free (list_entry (list_pop_front (&stale),
+                                struct elf_cache_entry, elem));
+}
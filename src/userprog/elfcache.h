@@ -0,0 +1,43 @@
+#ifndef USERPROG_ELFCACHE_H
+#define USERPROG_ELFCACHE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "filesys/off_t.h"
+
+struct inode;
+
+/* Executables whose layout is kept. */
+#define ELF_CACHE_SIZE 8
+
+/* Most loadable segments of an executable. */
+#define ELF_MAX_SEGMENTS 16
+
+/* A loadable segment, as load_segment() takes it. */
+struct elf_segment
+  {
+    off_t ofs;                  /* Page-aligned offset in the file. */
+    void *upage;                /* First page. */
+    uint32_t read_bytes;        /* Bytes read from the file. */
+    uint32_t zero_bytes;        /* Bytes zeroed after them. */
+    bool writable;              /* Writable, or read-only. */
+  };
+
+/* The layout of an executable, read from its ELF headers and
+   checked. */
+struct elf_image
+  {
+    void (*entry) (void);       /* Entry point. */
+    size_t stack_hint;          /* Stack size asked for, or 0. */
+    size_t seg_cnt;             /* Number of loadable segments. */
+    struct elf_segment segs[ELF_MAX_SEGMENTS];
+  };
+
+void elf_cache_init (void);
+bool elf_cache_lookup (struct inode *, struct elf_image *);
+void elf_cache_insert (struct inode *, unsigned write_cnt,
+                       const struct elf_image *);
+void elf_cache_drop_removed (void);
+
+#endif /* userprog/elfcache.h */
@@ -1,16 +1,20 @@
 #include "userprog/exception.h"
 #include <inttypes.h>
 #include <stdio.h>
+#include "userprog/fpu.h"
 #include "userprog/gdt.h"
 #include "threads/interrupt.h"
 #include "threads/thread.h"
 #include "threads/vaddr.h"
+#include "vm/page.h"
+#include "vm/vmstat.h"
 
 /* Number of page faults processed. */
 static long long page_fault_cnt;
 
 static void kill(struct intr_frame *);
 static void page_fault(struct intr_frame *);
+static void device_not_available(struct intr_frame *);
 
 /* Registers handlers for interrupts that can be caused by user
    programs.
@@ -45,7 +49,7 @@ void exception_init(void)
    intr_register_int(0, 0, INTR_ON, kill, "#DE Divide Error");
    intr_register_int(1, 0, INTR_ON, kill, "#DB Debug Exception");
    intr_register_int(6, 0, INTR_ON, kill, "#UD Invalid Opcode Exception");
-   intr_register_int(7, 0, INTR_ON, kill,
+   intr_register_int(7, 0, INTR_ON, device_not_available,
                      "#NM Device Not Available Exception");
    intr_register_int(11, 0, INTR_ON, kill, "#NP Segment Not Present");
    intr_register_int(12, 0, INTR_ON, kill, "#SS Stack Fault Exception");
@@ -141,6 +145,7 @@ page_fault(struct intr_frame *f)
 
    /* Count page faults. */
    page_fault_cnt++;
+   thread_current()->page_faults++;
 
    /* Determine cause. */
    not_present = (f->error_code & PF_P) == 0;
@@ -152,31 +157,29 @@ page_fault(struct intr_frame *f)
    /* If the fault address is not present from the user perspective, we need to load the page from the file */
    if (user && not_present)
    {
-      /* Check if the page exists. If yes, load it, otherwise check that the address is a correct stack address and load all pages that are needed */
+      /* Check if a region holds the page. If yes, load it, otherwise check that the address is a correct stack address, grow the stack down to it and load it with the pages below */
       void *rounded_addr = pg_round_down(fault_addr);
-      struct page *p = page_lookup(rounded_addr);
-      if (p == NULL)
+      if (page_vma_lookup(rounded_addr) == NULL)
       {
-         if (fault_addr >= PHYS_BASE - STACK_SIZE && fault_addr >= f->esp - 32)
-         {
-            success = true;
-            do
-            {
-               page_init(rounded_addr, true);
-               if (!page_load(rounded_addr))
-               {
-                  success = false;
-                  break;
-               }
-               rounded_addr += PGSIZE;
-            } while (page_lookup(rounded_addr) == NULL && rounded_addr < PHYS_BASE);
-         }
+         success = page_grow_stack(fault_addr, f->esp);
+         if (success)
+            vmstat_count(VMSTAT_STACK_FAULT);
       }
       else
       {
-         success = page_load(rounded_addr);
+         success = page_load(rounded_addr, write);
+         if (success)
+            page_fault_around(rounded_addr);
       }
    }
+   /* A write to a page that maps the zero page, by the process or by
+      the kernel on its behalf, gives the page a frame of its own */
+   else if (write && is_user_vaddr(fault_addr))
+   {
+      struct page *p = page_lookup(pg_round_down(fault_addr));
+      if (p != NULL && p->zero_mapped && p->writable)
+         success = page_load(fault_addr, true);
+   }
 
    if (!success)
    {
@@ -188,3 +191,14 @@ page_fault(struct intr_frame *f)
       kill(f);
    }
 }
+
+/* Device not available (#NM) handler.  A user program used the FPU
+   or SSE while CR0.TS was set, because another thread's state is
+   in the FPU registers, or none is: hand the FPU over to it.  The
+   kernel itself never uses the FPU. */
+static void
+device_not_available(struct intr_frame *f)
+{
+   if (f->cs != SEL_UCSEG || !fpu_claim())
+      kill(f);
+}
@@ -0,0 +1,274 @@
+#include "userprog/fdtable.h"
+#include <bitmap.h>
+#include <debug.h>
+#include <string.h>
+#include "filesys/file.h"
+#include "threads/malloc.h"
+#include "userprog/pipe.h"
+
+/* Creates a descriptor table with FD_TABLE_MIN slots.
+   Returns a null pointer if memory allocation fails. */
+struct fd_table *
+fd_table_create (void)
+{
+  struct fd_table *ft = malloc (sizeof *ft);
+  if (ft == NULL)
+    return NULL;
+
+  ft->capacity = FD_TABLE_MIN;
+  ft->slots = calloc (ft->capacity, sizeof *ft->slots);
+  ft->used = bitmap_create (ft->capacity);
+  if (ft->slots == NULL || ft->used == NULL)
+    {
+      free (ft->slots);
+      bitmap_destroy (ft->used);
+      free (ft);
+      return NULL;
+    }
+
+  /* The console descriptors are never handed out. */
+  bitmap_set_multiple (ft->used, 0, FD_FIRST, true);
+  ft->lowest_free = FD_FIRST;
+  return ft;
+}
+
+/* Releases the object in SLOT and empties it. */
+static void
+fd_slot_release (struct fd_slot *slot)
+{
+  switch (slot->type)
+    {
+    case FD_NONE:
+      break;
+    case FD_FILE:
+      file_close (slot->object);
+      break;
+    case FD_PIPE_READ:
+    case FD_PIPE_WRITE:
+      pipe_close_end (slot->object, slot->type == FD_PIPE_WRITE);
+      break;
+    }
+  slot->type = FD_NONE;
+  slot->object = NULL;
+}
+
+/* Closes every object still open in FT and frees FT. */
+void
+fd_table_destroy (struct fd_table *ft)
+{
+  int fd;
+
+  for (fd = 0; fd < ft->capacity; fd++)
+    fd_slot_release (&ft->slots[fd]);
+
+  free (ft->slots);
+  bitmap_destroy (ft->used);
+  free (ft);
+}
+
+/* Doubles the number of slots in FT, up to FD_TABLE_MAX.
+   Returns false if FT is already full size or memory runs out. */
+static bool
+fd_table_grow (struct fd_table *ft)
+{
+  int new_capacity = ft->capacity * 2;
+  struct fd_slot *slots;
+  struct bitmap *used;
+  int fd;
+
+  if (ft->capacity >= FD_TABLE_MAX)
+    return false;
+  if (new_capacity > FD_TABLE_MAX)
+    new_capacity = FD_TABLE_MAX;
+
+  slots = realloc (ft->slots, new_capacity * sizeof *slots);
+  if (slots == NULL)
+    return false;
+  ft->slots = slots;
+  memset (slots + ft->capacity, 0,
+          (new_capacity - ft->capacity) * sizeof *slots);
+
+  used = bitmap_create (new_capacity);
+  if (used == NULL)
+    return false;
+  for (fd = 0; fd < ft->capacity; fd++)
+    bitmap_set (used, fd, bitmap_test (ft->used, fd));
+  bitmap_destroy (ft->used);
+  ft->used = used;
+
+  ft->capacity = new_capacity;
+  return true;
+}
+
+/* Advances FT's lowest_free hint to the first unused slot at or
+   after its current value.  Leaves it at capacity if every slot is
+   used. */
+static void
+fd_table_advance (struct fd_table *ft)
+{
+  size_t fd = bitmap_scan (ft->used, ft->lowest_free, 1, false);
+  ft->lowest_free = fd != BITMAP_ERROR ? (int) fd : ft->capacity;
+}
+
+/* Stores OBJECT, of kind TYPE, in the lowest free slot of FT,
+   growing FT if it is full.  Returns the descriptor, or -1 if FT
+   cannot grow. */
+int
+fd_table_add (struct fd_table *ft, enum fd_type type, void *object)
+{
+  int fd;
+
+  ASSERT (type != FD_NONE && object != NULL);
+
+  if (ft->lowest_free >= ft->capacity && !fd_table_grow (ft))
+    return -1;
+
+  fd = ft->lowest_free;
+  ASSERT (!bitmap_test (ft->used, fd));
+  ft->slots[fd].type = type;
+  ft->slots[fd].object = object;
+  bitmap_mark (ft->used, fd);
+  ft->lowest_free = fd + 1;
+  fd_table_advance (ft);
+  return fd;
+}
+
+/* Returns the slot for FD in FT, or a null pointer if FD is out of
+   range. */
+static struct fd_slot *
+fd_table_slot (struct fd_table *ft, int fd)
+{
+  if (fd < 0 || fd >= ft->capacity)
+    return NULL;
+  return &ft->slots[fd];
+}
+
+/* Returns the file open as FD in FT, or a null pointer if FD is
+   not an open file. */
+struct file *
+fd_table_get (struct fd_table *ft, int fd)
+{
+  struct fd_slot *slot = fd_table_slot (ft, fd);
+  return slot != NULL && slot->type == FD_FILE ? slot->object : NULL;
+}
+
+/* Returns the pipe whose TYPE end is open as FD in FT, or a null
+   pointer if FD is not such a pipe end. */
+struct pipe *
+fd_table_get_pipe (struct fd_table *ft, int fd, enum fd_type type)
+{
+  struct fd_slot *slot = fd_table_slot (ft, fd);
+  return slot != NULL && slot->type == type ? slot->object : NULL;
+}
+
+/* Closes whatever is open as FD in FT.  Closing a redirected
+   console descriptor gives the console back to it.  Returns false
+   if FD was not open. */
+bool
+fd_table_close (struct fd_table *ft, int fd)
+{
+  struct fd_slot *slot = fd_table_slot (ft, fd);
+
+  if (slot == NULL || slot->type == FD_NONE)
+    return false;
+
+  fd_slot_release (slot);
+  if (fd >= FD_FIRST)
+    {
+      bitmap_reset (ft->used, fd);
+      if (fd < ft->lowest_free)
+        ft->lowest_free = fd;
+    }
+  return true;
+}
+
+/* Returns a new reference to the object in SLOT, or a null pointer
+   if memory runs out.  Pipe ends share the pipe; files get a new
+   handle at the same position. */
+static void *
+fd_slot_dup (const struct fd_slot *slot)
+{
+  struct file *file;
+
+  switch (slot->type)
+    {
+    case FD_FILE:
+      file = file_reopen (slot->object);
+      if (file != NULL)
+        file_seek (file, file_tell (slot->object));
+      return file;
+    case FD_PIPE_READ:
+    case FD_PIPE_WRITE:
+      pipe_dup (slot->object, slot->type == FD_PIPE_WRITE);
+      return slot->object;
+    default:
+      NOT_REACHED ();
+    }
+}
+
+/* Makes FD in FT refer to a new reference to the object in SLOT,
+   closing whatever FD referred to, growing FT as needed.  Returns
+   false if FD is out of range or memory runs out. */
+static bool
+fd_table_install (struct fd_table *ft, int fd, const struct fd_slot *slot)
+{
+  void *object;
+
+  if (fd < 0 || fd >= FD_TABLE_MAX)
+    return false;
+  while (fd >= ft->capacity)
+    if (!fd_table_grow (ft))
+      return false;
+
+  object = fd_slot_dup (slot);
+  if (object == NULL)
+    return false;
+
+  fd_slot_release (&ft->slots[fd]);
+  ft->slots[fd].type = slot->type;
+  ft->slots[fd].object = object;
+  bitmap_mark (ft->used, fd);
+  if (fd == ft->lowest_free)
+    fd_table_advance (ft);
+  return true;
+}
+
+/* Makes NEWFD in FT refer to what OLDFD refers to, closing NEWFD
+   first if it was open.  Duplicating onto 0 or 1 redirects the
+   console descriptors.  Returns false if OLDFD is not open or
+   NEWFD cannot be used. */
+bool
+fd_table_dup2 (struct fd_table *ft, int oldfd, int newfd)
+{
+  struct fd_slot *old = fd_table_slot (ft, oldfd);
+  struct fd_slot copy;
+
+  if (old == NULL || old->type == FD_NONE)
+    return false;
+  if (oldfd == newfd)
+    return true;
+
+  /* Growing FT may move OLD. */
+  copy = *old;
+  return fd_table_install (ft, newfd, &copy);
+}
+
+/* Copies PARENT's pipe descriptors into FT at the same numbers, so
+   that a process started with exec reads and writes the pipes
+   its parent set up, including redirected console descriptors.
+   Open files are not inherited.  Returns false if memory runs
+   out. */
+bool
+fd_table_inherit (struct fd_table *ft, const struct fd_table *parent)
+{
+  int fd;
+
+  for (fd = 0; fd < parent->capacity; fd++)
+    {
+      const struct fd_slot *slot = &parent->slots[fd];
+      if ((slot->type == FD_PIPE_READ || slot->type == FD_PIPE_WRITE)
+          && !fd_table_install (ft, fd, slot))
+        return false;
+    }
+  return true;
+}
@@ -0,0 +1,56 @@
+#ifndef USERPROG_FDTABLE_H
+#define USERPROG_FDTABLE_H
+
+#include <stdbool.h>
+
+struct bitmap;
+struct file;
+struct pipe;
+
+/* First descriptor handed out; 0 and 1 are the console. */
+#define FD_FIRST 2
+
+/* Initial and maximum number of slots in a descriptor table. */
+#define FD_TABLE_MIN 16
+#define FD_TABLE_MAX 8192
+
+/* Kinds of object a descriptor can refer to. */
+enum fd_type
+  {
+    FD_NONE,                    /* Free slot; the console for 0 and 1. */
+    FD_FILE,                    /* Open file or directory. */
+    FD_PIPE_READ,               /* Read end of a pipe. */
+    FD_PIPE_WRITE               /* Write end of a pipe. */
+  };
+
+/* One descriptor. */
+struct fd_slot
+  {
+    enum fd_type type;          /* What OBJECT is. */
+    void *object;               /* File or pipe. */
+  };
+
+/* A process's open file descriptors.
+   Starts small and doubles on demand.  A bitmap of used slots
+   and a cached lowest free slot make the lowest-free-fd
+   allocation cheap in the common case.  Descriptors 0 and 1 stay
+   marked used; they hold an object only while redirected with
+   fd_table_dup2(). */
+struct fd_table
+  {
+    struct fd_slot *slots;      /* Open objects, indexed by fd. */
+    struct bitmap *used;        /* Bit set for each fd in use. */
+    int capacity;               /* Number of slots in SLOTS. */
+    int lowest_free;            /* No free fd is below this one. */
+  };
+
+struct fd_table *fd_table_create (void);
+void fd_table_destroy (struct fd_table *);
+int fd_table_add (struct fd_table *, enum fd_type, void *object);
+struct file *fd_table_get (struct fd_table *, int fd);
+struct pipe *fd_table_get_pipe (struct fd_table *, int fd, enum fd_type);
+bool fd_table_close (struct fd_table *, int fd);
+bool fd_table_dup2 (struct fd_table *, int oldfd, int newfd);
+bool fd_table_inherit (struct fd_table *, const struct fd_table *parent);
+
+#endif /* userprog/fdtable.h */
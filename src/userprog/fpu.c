@@ -0,0 +1,125 @@
+#include "userprog/fpu.h"
+#include <debug.h>
+#include <round.h>
+#include <stdint.h>
+#include <string.h>
+#include "threads/cpu.h"
+#include "threads/interrupt.h"
+#include "threads/malloc.h"
+#include "threads/thread.h"
+
+/* Lazy FPU and SSE context switching.
+
+   The kernel is built with -msoft-float, so only user programs
+   use the FPU.  Its registers hold the state of one thread, the
+   owner, at a time.  Every context switch to any other thread
+   sets CR0.TS, so that the thread's first FPU or SSE instruction
+   raises #NM.  fpu_claim() then saves the owner's registers with
+   FXSAVE and loads the new thread's with FXRSTOR.  A thread gets
+   its save area on its first such instruction, so threads that
+   never use the FPU cost nothing.  See [IA32-v3a] 13.4 "Designing
+   OS Facilities for Saving x87 FPU, SSE and Extended States on
+   Task or Context Switches". */
+
+/* True if the CPU supports FXSAVE and SSE, so that user programs
+   may use the FPU.  Otherwise CR0.EM stays set and any FPU
+   instruction kills the process, as before. */
+static bool fpu_enabled;
+
+/* Thread whose state the FPU registers hold, or NULL. */
+static struct thread *fpu_owner;
+
+/* State a thread starts with: the defaults FNINIT sets up, with
+   every SSE exception masked and the XMM registers cleared. */
+static uint8_t fpu_initial[FPU_AREA_SIZE] __attribute__ ((aligned (16)));
+
+/* Returns T's FXSAVE area, which must be 16-byte aligned. */
+static void *
+fpu_area (struct thread *t)
+{
+  return (void *) ROUND_UP ((uintptr_t) t->fpu, 16);
+}
+
+/* Enables the FPU and SSE for user programs, if the CPU has them. */
+void
+fpu_init (void)
+{
+  if (!cpu_has_features (CPUID_FXSR | CPUID_SSE))
+    return;
+
+  cr4_write (cr4_read () | CR4_OSFXSR | CR4_OSXMMEXCPT);
+  cr0_write ((cr0_read () & ~CR0_EM) | CR0_MP | CR0_NE | CR0_TS);
+
+  /* Control word 0x37f masks every x87 exception and MXCSR 0x1f80
+     every SSE one; an abridged tag word of 0 marks every register
+     empty. */
+  memset (fpu_initial, 0, sizeof fpu_initial);
+  *(uint16_t *) fpu_initial = 0x37f;
+  *(uint32_t *) (fpu_initial + 24) = 0x1f80;
+  fpu_enabled = true;
+}
+
+/* Prepares the FPU for the thread just switched to.  Called on
+   every context switch. */
+void
+fpu_activate (void)
+{
+  uint32_t cr0;
+
+  if (!fpu_enabled)
+    return;
+  cr0 = cr0_read ();
+  if (fpu_owner == thread_current ())
+    cr0 &= ~CR0_TS;
+  else
+    cr0 |= CR0_TS;
+  cr0_write (cr0);
+}
+
+/* Makes the current thread the owner of the FPU, following #NM.
+   Returns false if the FPU is not usable or memory runs out. */
+bool
+fpu_claim (void)
+{
+  struct thread *cur = thread_current ();
+  enum intr_level old_level;
+
+  if (!fpu_enabled)
+    return false;
+  if (cur->fpu == NULL)
+    {
+      cur->fpu = malloc (FPU_AREA_SIZE + 15);
+      if (cur->fpu == NULL)
+        return false;
+      memcpy (fpu_area (cur), fpu_initial, FPU_AREA_SIZE);
+    }
+
+  /* The switch may not be interrupted half-way. */
+  old_level = intr_disable ();
+  cr0_write (cr0_read () & ~CR0_TS);
+  if (fpu_owner != cur)
+    {
+      if (fpu_owner != NULL)
+        asm volatile ("fxsave %0" : "=m" (*(uint8_t (*)[FPU_AREA_SIZE])
+                                           fpu_area (fpu_owner)));
+      asm volatile ("fxrstor %0" : : "m" (*(uint8_t (*)[FPU_AREA_SIZE])
+                                          fpu_area (cur)));
+      fpu_owner = cur;
+    }
+  intr_set_level (old_level);
+  return true;
+}
+
+/* Releases the FPU state of the exiting thread. */
+void
+fpu_exit (void)
+{
+  struct thread *cur = thread_current ();
+  enum intr_level old_level = intr_disable ();
+
+  if (fpu_owner == cur)
+    fpu_owner = NULL;
+  intr_set_level (old_level);
+  free (cur->fpu);
+  cur->fpu = NULL;
+}
@@ -0,0 +1,14 @@
+#ifndef USERPROG_FPU_H
+#define USERPROG_FPU_H
+
+#include <stdbool.h>
+
+/* Size of an FXSAVE area. */
+#define FPU_AREA_SIZE 512
+
+void fpu_init (void);
+void fpu_activate (void);
+bool fpu_claim (void);
+void fpu_exit (void);
+
+#endif /* userprog/fpu.h */
@@ -23,7 +23,8 @@ pagedir_create (void)
 }
 
 /* Destroys page directory PD, freeing all the pages it
-   references. */
+   references.  Large pages belong to whoever mapped them and must
+   have been unmapped already. */
 void
 pagedir_destroy (uint32_t *pd) 
 {
@@ -34,7 +35,7 @@ pagedir_destroy (uint32_t *pd)
 
   ASSERT (pd != init_page_dir);
   for (pde = pd; pde < pd + pd_no (PHYS_BASE); pde++)
-    if (*pde & PTE_P) 
+    if ((*pde & PTE_P) && !(*pde & PTE_PS))
       {
         uint32_t *pt = pde_get_pt (*pde);
         uint32_t *pte;
@@ -52,7 +53,8 @@ pagedir_destroy (uint32_t *pd)
    If PD does not have a page table for VADDR, behavior depends
    on CREATE.  If CREATE is true, then a new page table is
    created and a pointer into it is returned.  Otherwise, a null
-   pointer is returned. */
+   pointer is returned.  A VADDR mapped by a large page has no page
+   table entry, so a null pointer is returned for it. */
 static uint32_t *
 lookup_page (uint32_t *pd, const void *vaddr, bool create)
 {
@@ -66,6 +68,8 @@ lookup_page (uint32_t *pd, const void *vaddr, bool create)
   /* Check for a page table for VADDR.
      If one is missing, create one if requested. */
   pde = pd + pd_no (vaddr);
+  if (*pde & PTE_PS)
+    return NULL;
   if (*pde == 0) 
     {
       if (create)
@@ -126,8 +130,13 @@ void *
 pagedir_get_page (uint32_t *pd, const void *uaddr) 
 {
   uint32_t *pte;
+  uint32_t pde;
 
   ASSERT (is_user_vaddr (uaddr));
+
+  pde = pd[pd_no (uaddr)];
+  if ((pde & PTE_P) && (pde & PTE_PS))
+    return pde_get_large_page (pde) + ((uintptr_t) uaddr & (PTSPAN - 1));
   
   pte = lookup_page (pd, uaddr, false);
   if (pte != NULL && (*pte & PTE_P) != 0)
@@ -136,6 +145,51 @@ pagedir_get_page (uint32_t *pd, const void *uaddr)
     return NULL;
 }
 
+/* Maps the 4 MB of user virtual memory at UPAGE in page
+   directory PD to the physical memory at kernel virtual address
+   KPAGE with one large page, read/write if WRITABLE is true.
+   UPAGE and KPAGE must be 4 MB aligned, and nothing in the 4 MB at
+   UPAGE may be mapped.  Requires CR4_PSE. */
+void
+pagedir_set_huge (uint32_t *pd, void *upage, void *kpage, bool writable)
+{
+  uint32_t *pde = pd + pd_no (upage);
+
+  ASSERT ((uintptr_t) upage % PTSPAN == 0);
+  ASSERT (is_user_vaddr (upage));
+  ASSERT (pd != init_page_dir);
+
+  /* Drop the page table left behind by pages mapped here before */
+  if (*pde & PTE_P)
+    {
+      uint32_t *pt = pde_get_pt (*pde);
+      size_t i;
+
+      for (i = 0; i < PGSIZE / sizeof *pt; i++)
+        ASSERT ((pt[i] & PTE_P) == 0);
+      palloc_free_page (pt);
+    }
+  *pde = pde_create_large_user (kpage, writable);
+  invalidate_pagedir (pd);
+}
+
+/* Removes the large page that maps UPAGE in page directory PD, and
+   returns the kernel virtual address of the memory it mapped. */
+void *
+pagedir_clear_huge (uint32_t *pd, void *upage)
+{
+  uint32_t *pde = pd + pd_no (upage);
+  void *kpage;
+
+  ASSERT ((uintptr_t) upage % PTSPAN == 0);
+  ASSERT (is_user_vaddr (upage));
+
+  kpage = pde_get_large_page (*pde);
+  *pde = 0;
+  invalidate_pagedir (pd);
+  return kpage;
+}
+
 /* Marks user virtual page UPAGE "not present" in page
    directory PD.  Later accesses to the page will fault.  Other
    bits in the page table entry are preserved.
@@ -230,6 +284,13 @@ pagedir_activate (uint32_t *pd)
   asm volatile ("movl %0, %%cr3" : : "r" (vtop (pd)) : "memory");
 }
 
+/* Returns true if PD is the active page directory. */
+bool
+pagedir_is_active (uint32_t *pd)
+{
+  return active_pd () == (pd != NULL ? pd : init_page_dir);
+}
+
 /* Returns the currently active page directory. */
 static uint32_t *
 active_pd (void) 
@@ -0,0 +1,290 @@
+#include "userprog/pipe.h"
+#include <debug.h>
+#include <list.h>
+#include <stdint.h>
+#include <string.h>
+#include "threads/interrupt.h"
+#include "threads/malloc.h"
+#include "threads/procon.h"
+#include "threads/vaddr.h"
+#include "vm/frame.h"
+#include "vm/page.h"
+
+/* Bytes of data a pipe buffers before writers block. */
+#define PIPE_SIZE (32 * 1024)
+
+/* Whole pages a pipe holds before page-sized writers block. */
+#define PIPE_MAX_PAGES 16
+
+/* Frames of the user pool that queued pages of all pipes together
+   may take, as a fraction of the pool.  Queued frames cannot be
+   evicted, so past this writers go through the byte ring. */
+#define PIPE_POOL_SHARE 8
+
+/* Pages queued in all pipes.  Changed with interrupts off. */
+static size_t pipe_queued_pages;
+
+/* A pipe.
+   Small or unaligned writes are copied through the byte ring of
+   PC.  A write of a whole page from a page-aligned buffer is
+   copied once into a frame of its own, which is queued and later
+   mapped straight into a reader's page-aligned buffer.  To keep the
+   data in order, the ring and the page queue are never both
+   non-empty.  PC's lock and conditions guard the whole pipe. */
+struct pipe
+  {
+    struct procon pc;           /* Byte ring, lock and conditions. */
+    struct list pages;          /* Queued struct pipe_page. */
+    size_t page_ofs;            /* Bytes already read from first page. */
+    int readers;                /* Open read descriptors. */
+    int writers;                /* Open write descriptors. */
+  };
+
+/* A page of data waiting in a pipe. */
+struct pipe_page
+  {
+    struct list_elem elem;      /* Element in pipe's pages. */
+    struct frame *frame;        /* Frame holding the data. */
+  };
+
+/* Creates a pipe with one read and one write descriptor.
+   Returns a null pointer if memory runs out. */
+struct pipe *
+pipe_create (void)
+{
+  struct pipe *p = malloc (sizeof *p);
+  if (p == NULL)
+    return NULL;
+
+  if (!procon_try_init (&p->pc, PIPE_SIZE))
+    {
+      free (p);
+      return NULL;
+    }
+  list_init (&p->pages);
+  p->page_ofs = 0;
+  p->readers = 1;
+  p->writers = 1;
+  return p;
+}
+
+/* Counts one more queued page, unless queued pages already take
+   their share of the user pool.  Returns true if counted. */
+static bool
+pipe_reserve_page (void)
+{
+  enum intr_level old_level = intr_disable ();
+  bool ok = pipe_queued_pages < frame_total_cnt () / PIPE_POOL_SHARE;
+  if (ok)
+    pipe_queued_pages++;
+  intr_set_level (old_level);
+  return ok;
+}
+
+/* Counts one queued page less. */
+static void
+pipe_unreserve_page (void)
+{
+  enum intr_level old_level = intr_disable ();
+  ASSERT (pipe_queued_pages > 0);
+  pipe_queued_pages--;
+  intr_set_level (old_level);
+}
+
+/* Frees page PP, queued or about to be, and its frame. */
+static void
+pipe_free_page (struct pipe_page *pp)
+{
+  frame_free_frame (pp->frame);
+  free (pp);
+  pipe_unreserve_page ();
+}
+
+/* Frees P and any data still queued in it. */
+static void
+pipe_destroy (struct pipe *p)
+{
+  while (!list_empty (&p->pages))
+    {
+      struct pipe_page *pp = list_entry (list_pop_front (&p->pages),
+                                         struct pipe_page, elem);
+      pipe_free_page (pp);
+    }
+  procon_destroy (&p->pc);
+  free (p);
+}
+
+/* Records one more descriptor for the write end of P if WRITER,
+   otherwise for its read end. */
+void
+pipe_dup (struct pipe *p, bool writer)
+{
+  lock_acquire (&p->pc.lock);
+  if (writer)
+    p->writers++;
+  else
+    p->readers++;
+  lock_release (&p->pc.lock);
+}
+
+/* Closes one descriptor for the write end of P if WRITER, otherwise
+   for its read end.  Readers see end of file once every write
+   descriptor is closed and writers fail once every read descriptor
+   is.  Frees P when no descriptor is left. */
+void
+pipe_close_end (struct pipe *p, bool writer)
+{
+  bool last;
+
+  lock_acquire (&p->pc.lock);
+  if (writer)
+    p->writers--;
+  else
+    p->readers--;
+  ASSERT (p->readers >= 0 && p->writers >= 0);
+  cond_broadcast (&p->pc.not_empty, &p->pc.lock);
+  cond_broadcast (&p->pc.not_full, &p->pc.lock);
+  last = p->readers == 0 && p->writers == 0;
+  lock_release (&p->pc.lock);
+
+  if (last)
+    pipe_destroy (p);
+}
+
+/* Reads up to SIZE bytes from the first queued page of P into DST.
+   Hands the page over instead of copying it if DST is page-aligned
+   and has room for all of it.  Returns the number of bytes read. */
+static size_t
+pipe_read_page (struct pipe *p, uint8_t *dst, size_t size)
+{
+  struct pipe_page *pp = list_entry (list_front (&p->pages),
+                                     struct pipe_page, elem);
+  size_t n;
+
+  if (p->page_ofs == 0 && pg_ofs (dst) == 0 && size >= PGSIZE
+      && page_install_frame (dst, pp->frame))
+    n = PGSIZE;
+  else
+    {
+      n = PGSIZE - p->page_ofs;
+      if (n > size)
+        n = size;
+      memcpy (dst, (uint8_t *) pp->frame->kaddr + p->page_ofs, n);
+      p->page_ofs += n;
+      if (p->page_ofs < PGSIZE)
+        return n;
+      frame_free_frame (pp->frame);
+    }
+
+  list_remove (&pp->elem);
+  free (pp);
+  pipe_unreserve_page ();
+  p->page_ofs = 0;
+  return n;
+}
+
+/* Reads up to SIZE bytes from P into BUFFER, which must be loaded and
+   pinned.  Waits until some data is available, then takes as much as
+   fits without waiting again.  Returns the number of bytes read, or 0
+   at end of file. */
+int
+pipe_read (struct pipe *p, void *buffer_, unsigned size)
+{
+  uint8_t *buffer = buffer_;
+  unsigned done = 0;
+
+  if (size == 0)
+    return 0;
+
+  lock_acquire (&p->pc.lock);
+  while (p->pc.current == 0 && list_empty (&p->pages) && p->writers > 0)
+    cond_wait (&p->pc.not_empty, &p->pc.lock);
+
+  while (done < size)
+    {
+      size_t n;
+      if (!list_empty (&p->pages))
+        n = pipe_read_page (p, buffer + done, size - done);
+      else
+        n = procon_get (&p->pc, buffer + done, size - done);
+      if (n == 0)
+        break;
+      done += n;
+    }
+
+  if (done > 0)
+    cond_broadcast (&p->pc.not_full, &p->pc.lock);
+  lock_release (&p->pc.lock);
+  return done;
+}
+
+/* Writes SIZE bytes from BUFFER, which must be loaded and pinned, to
+   P, waiting for room as needed.  Returns the number of bytes
+   written, which is less than SIZE only if every read descriptor is
+   closed, or -1 if nothing could be written. */
+int
+pipe_write (struct pipe *p, const void *buffer_, unsigned size)
+{
+  const uint8_t *buffer = buffer_;
+  unsigned done = 0;
+
+  while (done < size)
+    {
+      const uint8_t *src = buffer + done;
+      size_t want = size - done;
+      struct pipe_page *pp = NULL;
+      bool queued = false;
+      size_t n = 0;
+
+      /* Copy a whole aligned page into a frame of its own before
+         taking the lock, but only into a free frame: evicting
+         someone's page to pass data along is not worth it. */
+      if (pg_ofs (src) == 0 && want >= PGSIZE && pipe_reserve_page ())
+        {
+          pp = malloc (sizeof *pp);
+          if (pp != NULL)
+            pp->frame = frame_try_get_frame (PAL_USER);
+          if (pp == NULL || pp->frame == NULL)
+            {
+              free (pp);
+              pp = NULL;
+              pipe_unreserve_page ();
+            }
+          else
+            {
+              memcpy (pp->frame->kaddr, src, PGSIZE);
+              src = pp->frame->kaddr;
+              want = PGSIZE;
+            }
+        }
+
+      lock_acquire (&p->pc.lock);
+      while (p->readers > 0)
+        {
+          if (pp != NULL && p->pc.current == 0
+              && list_size (&p->pages) < PIPE_MAX_PAGES)
+            {
+              list_push_back (&p->pages, &pp->elem);
+              queued = true;
+              n = PGSIZE;
+              break;
+            }
+          if (list_empty (&p->pages) && p->pc.current < p->pc.size)
+            {
+              n = procon_put (&p->pc, src, want);
+              break;
+            }
+          cond_wait (&p->pc.not_full, &p->pc.lock);
+        }
+      if (n > 0)
+        cond_broadcast (&p->pc.not_empty, &p->pc.lock);
+      lock_release (&p->pc.lock);
+
+      if (pp != NULL && !queued)
+        pipe_free_page (pp);
+      if (n == 0)
+        return done > 0 ? (int) done : -1;
+      done += n;
+    }
+  return done;
+}
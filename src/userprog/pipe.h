@@ -0,0 +1,14 @@
+#ifndef USERPROG_PIPE_H
+#define USERPROG_PIPE_H
+
+#include <stdbool.h>
+
+struct pipe;
+
+struct pipe *pipe_create (void);
+void pipe_dup (struct pipe *, bool writer);
+void pipe_close_end (struct pipe *, bool writer);
+int pipe_read (struct pipe *, void *buffer, unsigned size);
+int pipe_write (struct pipe *, const void *buffer, unsigned size);
+
+#endif /* userprog/pipe.h */
@@ -2,18 +2,27 @@
 #include "filesys/directory.h"
 #include "filesys/file.h"
 #include "filesys/filesys.h"
+#include "filesys/inode.h"
 #include "threads/flags.h"
 #include "threads/init.h"
 #include "threads/interrupt.h"
+#include "threads/malloc.h"
 #include "threads/palloc.h"
 #include "threads/synch.h"
 #include "threads/thread.h"
 #include "threads/vaddr.h"
+#include "userprog/aio.h"
+#include "userprog/elfcache.h"
+#include "userprog/fdtable.h"
+#include "userprog/fpu.h"
 #include "userprog/gdt.h"
 #include "userprog/pagedir.h"
 #include "userprog/syscall.h"
 #include "userprog/tss.h"
+#include "vm/mmap.h"
 #include "vm/page.h"
+#include "vm/shm.h"
+#include "vm/vmstat.h"
 #include <debug.h>
 #include <inttypes.h>
 #include <round.h>
@@ -24,8 +33,8 @@
 #define WORD_SIZE 4
 
 static thread_func start_process NO_RETURN;
-static bool load(const char *cmdline, void (**eip)(void), void **esp,
-                 char *args);
+static bool load(const char *file_name, void (**eip)(void), void **esp,
+                 const char *cmd_line, size_t cmd_len);
 
 /* Starts a new thread running a user program loaded from
    FILENAME.  The new thread may be scheduled (and may even exit)
@@ -36,14 +45,16 @@ tid_t process_execute(const char *file_name)
   char *fn_copy, *name, *save_ptr;
   // Max filename size is 14 + null terminator
   char exec_file_name[15];
+  size_t size;
   tid_t tid;
 
-  /* Make a copy of FILE_NAME.
+  /* Make a copy of FILE_NAME (limited to 4kB).
      Otherwise there's a race between the caller and load(). */
-  fn_copy = palloc_get_page(0);
+  size = strnlen(file_name, PGSIZE - 1) + 1;
+  fn_copy = malloc(size);
   if (fn_copy == NULL)
     return TID_ERROR;
-  strlcpy(fn_copy, file_name, PGSIZE);
+  strlcpy(fn_copy, file_name, size);
 
   /*Get first argument from *file_name*/
   strlcpy(exec_file_name, file_name, sizeof exec_file_name);
@@ -52,7 +63,7 @@ tid_t process_execute(const char *file_name)
   /* Create a new thread to execute FILE_NAME. */
   tid = thread_create(name, PRI_DEFAULT, start_process, fn_copy);
   if (tid == TID_ERROR)
-    palloc_free_page(fn_copy);
+    free(fn_copy);
 
   /* Wait for the child to load */
   struct process *p = get_child(tid);
@@ -75,10 +86,12 @@ tid_t process_execute(const char *file_name)
 /* A thread function that loads a user process and starts it
    running. */
 static void
-start_process(void *file_name_)
+start_process(void *cmd_line_)
 {
+  char *cmd_line = cmd_line_;
+  size_t cmd_len = strlen(cmd_line);
   char *save_ptr;
-  char *file_name = strtok_r(file_name_, " ", &save_ptr);
+  char *file_name = strtok_r(cmd_line, " ", &save_ptr);
   struct intr_frame if_;
   bool success;
 
@@ -87,7 +100,9 @@ start_process(void *file_name_)
   if_.gs = if_.fs = if_.es = if_.ds = if_.ss = SEL_UDSEG;
   if_.cs = SEL_UCSEG;
   if_.eflags = FLAG_IF | FLAG_MBS;
-  success = load(file_name, &if_.eip, &if_.esp, save_ptr);
+  success = file_name != NULL
+            && load(file_name, &if_.eip, &if_.esp, cmd_line, cmd_len);
+  free(cmd_line);
 
   /* Signal the parent that the process has been loaded */
   sema_up(&thread_current()->wait_for_load);
@@ -170,8 +185,7 @@ int process_wait(pid_t child_pid)
   }
 
   list_remove(&child->elem);
-  /* Needs normal free as allocated on kernel memory */
-  palloc_free_page(child);
+  free_process(child);
 
   return status;
 }
@@ -192,8 +206,7 @@ void process_remove_children(struct thread *cur)
     if (child->killed)
     {
       list_remove(&child->elem);
-      /* Needs normal free as allocated on kernel memory */
-      palloc_free_page(child);
+      free_process(child);
     }
     /* If the child is still running, remove the parent pointer to indicate
        that it should free itself */
@@ -210,32 +223,42 @@ void process_exit(void)
 {
   struct thread *cur = thread_current();
   uint32_t *pd;
-  int fd;
+
+  /* Let outstanding asynchronous requests finish before their
+     buffers and files go away */
+  aio_exit();
+
+  /* Give up the FPU */
+  fpu_exit();
 
   /* Close all open files */
   if (cur->fd_table != NULL)
   {
-
-    for (fd = 2; fd < MAX_OPEN_FILES; fd++)
-    {
-      if (cur->fd_table[fd] != NULL)
-      {
-        close(fd);
-      }
-    }
-    free(cur->fd_table);
+    lock_acquire(get_filesys_lock());
+    fd_table_destroy(cur->fd_table);
+    lock_release(get_filesys_lock());
+    cur->fd_table = NULL;
   }
 
-  /* Close the executable file and allow writing to it
+  /* Report memory use while the pages are still there */
+  vmstat_exit();
+
+  /* Write back mapped files and unmap shared memory while the pages
+     are still there */
+  mmap_exit();
+  shm_exit();
+
+  /* Free the supplemental page table */
+  page_exit();
+
+  /* Close the executable file and allow writing to it, now that no
+     shared code frame refers to its inode.
    May be null if process creating was unsuccessful */
   if (cur->executable != NULL)
   {
     file_close(cur->executable);
   }
 
-  /* Free the supplemental page table */
-  page_exit();
-
   /* Remove all parent pointers from child processes */
   process_remove_children(cur);
 
@@ -259,8 +282,7 @@ void process_exit(void)
   /* If its parent already exited, free the process struct */
   if (cur->process->parent == NULL)
   {
-    /* Needs normal free as allocated on kernel memory */
-    palloc_free_page(cur->process);
+    free_process(cur->process);
   }
   else
   {
@@ -280,12 +302,21 @@ void process_activate(void)
 {
   struct thread *t = thread_current();
 
-  /* Activate thread's page tables. */
-  pagedir_activate(t->pagedir);
+  /* Activate thread's page tables, unless they already are.  A
+     kernel thread never touches user memory, so it keeps running on
+     whichever page directory is active instead of flushing the TLB.
+     That page directory cannot go away meanwhile: process_exit()
+     switches away from it before destroying it. */
+  if (t->pagedir != NULL && !pagedir_is_active(t->pagedir))
+    pagedir_activate(t->pagedir);
 
   /* Set thread's kernel stack for use in processing
      interrupts. */
   tss_update();
+
+  /* Trap the thread's first FPU instruction unless the FPU holds
+     its state. */
+  fpu_activate();
 }
 
 /* We load ELF binaries.  The following definitions are taken
@@ -351,25 +382,28 @@ struct Elf32_Phdr
 #define PF_W 2 /* Writable. */
 #define PF_R 4 /* Readable. */
 
-static bool setup_stack(void **esp);
-static void parse_arguments(void **esp, const char *file_name, char *args);
+static bool setup_stack(void **esp, size_t stack_hint);
+static bool read_elf_image(const char *file_name, struct file *file,
+                           struct elf_image *image);
+static bool push_arguments(void **esp, const char *cmd_line, size_t cmd_len);
 static bool validate_segment(const struct Elf32_Phdr *, struct file *);
 static bool load_segment(struct file *file, off_t ofs, uint8_t *upage,
                          uint32_t read_bytes, uint32_t zero_bytes,
                          bool writable);
 
-/* Loads an ELF executable from FILE_NAME into the current thread.
-   Stores the executable's entry point into *EIP
+/* Loads an ELF executable from FILE_NAME into the current thread,
+   passing it the words of the CMD_LEN bytes at CMD_LINE as its
+   arguments.  Stores the executable's entry point into *EIP
    and its initial stack pointer into *ESP.
    Returns true if successful, false otherwise. */
-bool load(const char *file_name, void (**eip)(void), void **esp, char *args)
+bool load(const char *file_name, void (**eip)(void), void **esp,
+          const char *cmd_line, size_t cmd_len)
 {
   struct thread *t = thread_current();
-  struct Elf32_Ehdr ehdr;
+  struct elf_image image;
   struct file *file = NULL;
-  off_t file_ofs;
   bool success = false;
-  int i;
+  size_t i;
 
   /* Allocate and activate page directory. */
   t->pagedir = pagedir_create();
@@ -389,24 +423,104 @@ bool load(const char *file_name, void (**eip)(void), void **esp, char *args)
   }
 
   /*Allocate thread's file descriptor table*/
-  t->fd_table = calloc(MAX_OPEN_FILES, sizeof(struct file *));
+  t->fd_table = fd_table_create();
   if (t->fd_table == NULL)
   {
     goto done;
   }
 
+  /* Inherit the parent's pipes, which stays blocked until we are loaded */
+  struct thread *parent = t->process->parent;
+  if (parent != NULL && parent->fd_table != NULL &&
+      !fd_table_inherit(t->fd_table, parent->fd_table))
+  {
+    goto done;
+  }
+
   /* Allocate the supplemental page table */
   if (!page_init_table())
   {
     goto done;
   }
 
+  /* Read and verify the executable's layout, unless it is kept from
+     an earlier exec and the file has not been written since. */
+  struct inode *inode = file_get_inode(file);
+  if (!elf_cache_lookup(inode, &image))
+  {
+    unsigned write_cnt = inode_get_write_cnt(inode);
+    if (!read_elf_image(file_name, file, &image))
+      goto done;
+
+    /* A write that went on meanwhile may have torn the headers we
+       read, so only keep them if there was none. */
+    if (inode_get_write_cnt(inode) == write_cnt)
+      elf_cache_insert(inode, write_cnt, &image);
+  }
+
+  /* Add the regions of the loadable segments. */
+  for (i = 0; i < image.seg_cnt; i++)
+  {
+    struct elf_segment *seg = &image.segs[i];
+    if (!load_segment(file, seg->ofs, seg->upage, seg->read_bytes,
+                      seg->zero_bytes, seg->writable))
+      goto done;
+  }
+
+  /* Set up stack. */
+  if (!setup_stack(esp, image.stack_hint))
+    goto done;
+
+  /* Push arguments */
+  if (!push_arguments(esp, cmd_line, cmd_len))
+    goto done;
+
+  /* Start address. */
+  *eip = image.entry;
+
+  success = true;
+
+done:
+  /* We arrive here whether the load is successful or not. */
+
+  /* Save the success of the load */
+  t->process->successful_load = success;
+
+  if (success)
+  {
+    file_deny_write(file);
+    t->executable = file;
+  }
+  else
+  {
+    file_close(file);
+  }
+  return success;
+}
+
+/* load() helpers. */
+
+/* Reads the ELF header and program headers of FILE, opened as
+   FILE_NAME, into IMAGE, checking that FILE is an executable this
+   loader can run.  Returns true if successful, false otherwise. */
+static bool
+read_elf_image(const char *file_name, struct file *file,
+               struct elf_image *image)
+{
+  struct Elf32_Ehdr ehdr;
+  off_t file_ofs;
+  int i;
+
   /* Read and verify executable header. */
+  file_seek(file, 0);
   if (file_read(file, &ehdr, sizeof ehdr) != sizeof ehdr || memcmp(ehdr.e_ident, "\177ELF\1\1\1", 7) || ehdr.e_type != 2 || ehdr.e_machine != 3 || ehdr.e_version != 1 || ehdr.e_phentsize != sizeof(struct Elf32_Phdr) || ehdr.e_phnum > 1024)
   {
     printf("load: %s: error loading executable\n", file_name);
-    goto done;
+    return false;
   }
+  image->entry = (void (*)(void))ehdr.e_entry;
+  image->stack_hint = 0;
+  image->seg_cnt = 0;
 
   /* Read program headers. */
   file_ofs = ehdr.e_phoff;
@@ -415,90 +529,59 @@ bool load(const char *file_name, void (**eip)(void), void **esp, char *args)
     struct Elf32_Phdr phdr;
 
     if (file_ofs < 0 || file_ofs > file_length(file))
-      goto done;
+      return false;
     file_seek(file, file_ofs);
 
     if (file_read(file, &phdr, sizeof phdr) != sizeof phdr)
-      goto done;
+      return false;
     file_ofs += sizeof phdr;
     switch (phdr.p_type)
     {
     case PT_NULL:
     case PT_NOTE:
     case PT_PHDR:
-    case PT_STACK:
     default:
       /* Ignore this segment. */
       break;
+    case PT_STACK:
+      /* The stack size asked for with "ld -z stack-size", if any. */
+      image->stack_hint = phdr.p_memsz;
+      break;
     case PT_DYNAMIC:
     case PT_INTERP:
     case PT_SHLIB:
-      goto done;
+      return false;
     case PT_LOAD:
-      if (validate_segment(&phdr, file))
+      if (validate_segment(&phdr, file) && image->seg_cnt < ELF_MAX_SEGMENTS)
       {
-        bool writable = (phdr.p_flags & PF_W) != 0;
-        bool executable = (phdr.p_flags & PF_X) != 0;
-        uint32_t file_page = phdr.p_offset & ~PGMASK;
-        uint32_t mem_page = phdr.p_vaddr & ~PGMASK;
+        struct elf_segment *seg = &image->segs[image->seg_cnt++];
         uint32_t page_offset = phdr.p_vaddr & PGMASK;
-        uint32_t read_bytes, zero_bytes;
+        seg->writable = (phdr.p_flags & PF_W) != 0;
+        seg->ofs = phdr.p_offset & ~PGMASK;
+        seg->upage = (void *)(phdr.p_vaddr & ~PGMASK);
         if (phdr.p_filesz > 0)
         {
           /* Normal segment.
              Read initial part from disk and zero the rest. */
-          read_bytes = page_offset + phdr.p_filesz;
-          zero_bytes = (ROUND_UP(page_offset + phdr.p_memsz, PGSIZE) - read_bytes);
+          seg->read_bytes = page_offset + phdr.p_filesz;
+          seg->zero_bytes = (ROUND_UP(page_offset + phdr.p_memsz, PGSIZE) - seg->read_bytes);
         }
         else
         {
           /* Entirely zero.
              Don't read anything from disk. */
-          read_bytes = 0;
-          zero_bytes = ROUND_UP(page_offset + phdr.p_memsz, PGSIZE);
+          seg->read_bytes = 0;
+          seg->zero_bytes = ROUND_UP(page_offset + phdr.p_memsz, PGSIZE);
         }
-        if (!load_segment(file, file_page, (void *)mem_page, read_bytes,
-                          zero_bytes, writable))
-          goto done;
       }
       else
-        goto done;
+        return false;
       break;
     }
   }
-
-  /* Set up stack. */
-  if (!setup_stack(esp))
-    goto done;
-
-  /* Parse arguments */
-  parse_arguments(esp, file_name, args);
-
-  /* Start address. */
-  *eip = (void (*)(void))ehdr.e_entry;
-
-  success = true;
-
-done:
-  /* We arrive here whether the load is successful or not. */
-
-  /* Save the success of the load */
-  t->process->successful_load = success;
-
-  if (success)
-  {
-    file_deny_write(file);
-    t->executable = file;
-  }
-  else
-  {
-    file_close(file);
-  }
-  return success;
+  return true;
 }
 
-/* load() helpers. */
-
 static bool install_page(void *upage, void *kpage, bool writable);
 
 /* Checks whether PHDR describes a valid, loadable segment in
@@ -558,6 +641,9 @@ validate_segment(const struct Elf32_Phdr *phdr, struct file *file)
    The pages initialized by this function must be writable by the
    user process if WRITABLE is true, read-only otherwise.
 
+   With large pages on, each whole, aligned 4 MB of the zeroed part
+   of a writable segment is mapped with a large page.
+
    Return true if successful, false if a memory allocation error
    or disk read error occurs. */
 static bool
@@ -568,52 +654,54 @@ load_segment(struct file *file, off_t ofs, uint8_t *upage,
   ASSERT(pg_ofs(upage) == 0);
   ASSERT(ofs % PGSIZE == 0);
 
-  file_seek(file, ofs);
-  while (read_bytes > 0 || zero_bytes > 0)
+  /* Split off the large pages into a region of their own */
+  uint8_t *end = upage + read_bytes + zero_bytes;
+  uint8_t *huge_start = (uint8_t *)ROUND_UP((uintptr_t)upage + ROUND_UP(read_bytes, PGSIZE),
+                                            HUGE_PAGE_SIZE);
+  uint8_t *huge_end = (uint8_t *)ROUND_DOWN((uintptr_t)end, HUGE_PAGE_SIZE);
+  if (writable && page_huge_enabled() && huge_start < huge_end)
   {
-    /* Calculate how to fill this page.
-       We will read PAGE_READ_BYTES bytes from FILE
-       and zero the final PAGE_ZERO_BYTES bytes. */
-    size_t page_read_bytes = read_bytes < PGSIZE ? read_bytes : PGSIZE;
-    size_t page_zero_bytes = PGSIZE - page_read_bytes;
-
-    /* Get a page of memory. */
-    struct page *kpage = page_init(upage, writable);
-    if (kpage == NULL)
-      return false;
+    return (huge_start == upage
+            || load_segment(file, ofs, upage, read_bytes,
+                            huge_start - upage - read_bytes, writable))
+           && page_add_huge(huge_start, (huge_end - huge_start) / PGSIZE)
+           && (huge_end == end
+               || load_segment(NULL, 0, huge_end, 0, end - huge_end, writable));
+  }
 
-    if (page_read_bytes > 0)
-    {
-      kpage->file = file;
-      kpage->ofs = ofs;
-      kpage->read_bytes = page_read_bytes;
-    }
+  /* Add a region for the segment.  Its pages are read from
+     FILE or zeroed on first touch. */
+  struct vma *v = page_add_vma(upage, (read_bytes + zero_bytes) / PGSIZE, writable);
+  if (v == NULL)
+    return false;
 
-    if (upage < thread_current()->code_segment)
-    {
-      kpage->type = VM_BIN;
-    }
+  if (read_bytes > 0)
+  {
+    v->file = file;
+    v->ofs = ofs;
+    v->file_bytes = read_bytes;
+  }
 
-    /* Advance. */
-    read_bytes -= page_read_bytes;
-    zero_bytes -= page_zero_bytes;
-    ofs += page_read_bytes;
-    upage += PGSIZE;
+  if (upage < thread_current()->code_segment)
+  {
+    v->type = VM_BIN;
   }
   return true;
 }
 
-/* Create a minimal stack by mapping a zeroed page at the top of
-   user virtual memory. */
+/* Create a stack at the top of user virtual memory.  A program that
+   gives its stack size as STACK_HINT gets that much stack at most,
+   and up to STACK_GROW_PAGES of it mapped now; any other program
+   starts with one zeroed page. */
 static bool
-setup_stack(void **esp)
+setup_stack(void **esp, size_t stack_hint)
 {
   bool success = false;
-  void *upage = ((uint8_t *)PHYS_BASE - PGSIZE);
-
-  page_init(upage, true);
+  size_t page_cnt = DIV_ROUND_UP(stack_hint, PGSIZE);
 
-  if (page_load(upage))
+  if (page_cnt > STACK_GROW_PAGES)
+    page_cnt = STACK_GROW_PAGES;
+  if (page_add_stack(stack_hint, page_cnt))
   {
     success = true;
     *esp = PHYS_BASE;
@@ -626,98 +714,50 @@ setup_stack(void **esp)
   return success;
 }
 
-/* Parse the arguments and push them onto the stack */
-static void
-parse_arguments(void **esp, const char *file_name, char *args)
+/* Pushes the words of the CMD_LEN bytes at CMD_LINE, separated by
+   spaces or null characters, onto the stack at *ESP as the
+   arguments of main().  The words are copied up at once and split
+   in place, and argv[] is built in the same pass, from the last
+   word.  Returns false if they do not fit in the top stack page. */
+static bool
+push_arguments(void **esp, const char *cmd_line, size_t cmd_len)
 {
+  char *args = (char *)*esp - (cmd_len + 1);
+  uint32_t *sp = (uint32_t *)((uintptr_t)args & ~(WORD_SIZE - 1));
+  uint32_t argv;
+  int argc = 0;
+  size_t i;
+
+  /* At worst every other byte starts a word, and argv[argc], argv,
+     argc and the return address go below argv[] */
+  if (cmd_len + WORD_SIZE + ((cmd_len + 1) / 2 + 4) * WORD_SIZE > PGSIZE)
+    return false;
 
-  char **tokens = palloc_get_page(0);
-  char *token, *save_ptr, *fn_copy, *place_holder_argv;
-  int i, alignment, argc = 0;
-
-  /* Make a copy of FILE_NAME (limited to 4kB).*/
-  fn_copy = palloc_get_page(0);
-  if (fn_copy == NULL)
-    return TID_ERROR;
-  strlcpy(fn_copy, file_name, PGSIZE);
-
-  token = strtok_r(fn_copy, " ", &save_ptr);
-
-  /* Tokenize the filename and store each token into an array */
-  for (i = 0; token != NULL; i++, token = strtok_r(NULL, " ", &save_ptr))
-  {
-    tokens[i] = token;
-  }
-  /* Tokenize the arguments and store each token into an array */
-  token = strtok_r(args, " ", &save_ptr);
-  for (i = i; token != NULL; i++, token = strtok_r(NULL, " ", &save_ptr))
-  {
-    tokens[i] = token;
-  }
-
-  argc = i;
-  char *argv[argc];
-
-  /* Reduce by 1 to start at the correct index */
-  i--;
-  /* Push each token onto the stack */
-  while (i >= 0)
-  {
-
-    /* Separator between the arguments */
-    *esp -= sizeof(char);
-    memset(*esp, '\0', sizeof(char));
-
-    /* Push the argument onto the stack */
-    *esp -= strlen(tokens[i]);
-    memcpy(*esp, tokens[i], strlen(tokens[i]));
-
-    argv[i] = *esp;
-
-    i--;
-  }
-
-  /* Perform alignment if needed after pushing arguments onto the stack
-  as pointers must be stored at addresses that are word aligned */
-
-  alignment = (uint8_t)*esp % WORD_SIZE;
-  *esp -= alignment;
-  memset(*esp, 0, alignment);
-
-  /* Push the last argument which consists of four bytes of 0's */
-  *esp -= WORD_SIZE;
-  memset(*esp, 0, WORD_SIZE);
-
-  argv[argc] = *esp;
+  memcpy(args, cmd_line, cmd_len);
+  args[cmd_len] = '\0';
 
-  /* Push all addresses of the arguments onto the stack */
-  i = argc - 1;
-  while (i >= 0)
+  /* Push argv[argc], then a pointer to each word from the last */
+  *--sp = 0;
+  for (i = cmd_len; i-- > 0;)
   {
-
-    *esp -= sizeof(char *);
-    memcpy(*esp, &argv[i], sizeof(char *));
-
-    i--;
+    if (args[i] == ' ')
+      args[i] = '\0';
+    else if (args[i] != '\0'
+             && (i == 0 || args[i - 1] == ' ' || args[i - 1] == '\0'))
+    {
+      *--sp = (uint32_t)(args + i);
+      argc++;
+    }
   }
+  argv = (uint32_t)sp;
 
-  place_holder_argv = *esp;
+  /* Push argv, argc and the return address */
+  *--sp = argv;
+  *--sp = argc;
+  *--sp = 0;
 
-  /* Push address of argv[0] onto the stack */
-  *esp -= sizeof(char **);
-  memcpy(*esp, &place_holder_argv, sizeof(char **));
-
-  /* Push argc (argument count) onto the stack */
-  *esp -= sizeof(int);
-  memcpy(*esp, &argc, sizeof(int));
-
-  /* Push return address */
-  *esp -= sizeof(void *);
-  memset(*esp, 0, sizeof(void *));
-
-  /* Free ressources */
-  palloc_free_page(fn_copy);
-  palloc_free_page(tokens);
+  *esp = sp;
+  return true;
 }
 
 /* Adds a mapping from user virtual address UPAGE to kernel
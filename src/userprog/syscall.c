@@ -9,13 +9,25 @@
 #include "threads/synch.h"
 #include "threads/thread.h"
 #include "threads/vaddr.h"
+#include "userprog/aio.h"
+#include "userprog/elfcache.h"
+#include "userprog/fdtable.h"
 #include "userprog/pagedir.h"
+#include "userprog/pipe.h"
+#include "userprog/tss.h"
+#include "vm/mmap.h"
+#include "vm/page.h"
+#include "vm/shm.h"
+#include "vm/vmstat.h"
 #include <stdio.h>
+#include <string.h>
 #include <syscall-nr.h>
 #include "filesys/rwlock.h"
 
 
-static void syscall_handler (struct intr_frame *);
+/* Fast system call entry point in sysenter.S. */
+void sysenter_entry (void);
+
 /* System calls */
 void halt (void);
 void exit (int status);
@@ -35,10 +47,17 @@ bool mkdir (const char *dir);
 bool readdir (int fd, char *name);
 bool isdir (int fd);
 int inumber (int fd);
+mapid_t mmap (int fd, void *addr);
+void munmap (mapid_t mapping);
+int pipe (int *fds);
+int dup2 (int oldfd, int newfd);
 
 struct lock filesys_lock;
 struct rw_lock rw_lock;
 
+/* True if user programs may enter through SYSENTER */
+static bool sysenter_enabled;
+
 /* Returns the filesys_lock (used in process.c) */
 struct lock *
 get_filesys_lock (void)
@@ -46,59 +65,53 @@ get_filesys_lock (void)
   return &filesys_lock;
 }
 
-/* Allocates next available fd in current thread's fd_table of open files.
-   Returns fd if fd_table has availability for new open file, otherwise return
-   -1  */
-static int
-allocate_fd (void)
+/* Returns the rw_lock guarding file reads and writes (used in aio.c) */
+struct rw_lock *
+get_rw_lock (void)
 {
-  int fd;
-  struct thread *t = thread_current ();
+  return &rw_lock;
+}
 
-  for (fd = 2; fd < MAX_OPEN_FILES; fd++)
-    {
-      if (t->fd_table[fd] == NULL)
-        {
-          break;
-        }
-    }
+/* Returns file of fd from current thread's fd_table, and returns NULL if fd is
+ * an invalid fd for files */
+struct file *
+get_file (int fd)
+{
+  struct thread *t = thread_current ();
 
-  if (fd < MAX_OPEN_FILES)
+  if (t->fd_table == NULL)
     {
-      return fd;
+      return NULL;
     }
 
-  return -1;
+  return fd_table_get (t->fd_table, fd);
 }
 
-/* Returns file of fd from current thread's fd_table, and returns NULL if fd is
- * an invalid fd for files */
-struct file *
-get_file (int fd)
+/* Returns the pipe whose TYPE end is open as fd in the current thread's
+   fd_table, and returns NULL if fd is not such a pipe end */
+static struct pipe *
+get_pipe (int fd, enum fd_type type)
 {
   struct thread *t = thread_current ();
 
-  if (fd < 2 || fd >= MAX_OPEN_FILES)
+  if (t->fd_table == NULL)
     {
       return NULL;
     }
 
-  return t->fd_table[fd];
+  return fd_table_get_pipe (t->fd_table, fd, type);
 }
 
-/* Closes open file of fd, and removes open file from current thread's fd_table
- */
+/* Closes the open file or pipe end of fd, and removes it from current
+   thread's fd_table */
 static void
 close_openfile (int fd)
 {
-
   struct thread *t = thread_current ();
-  struct file *file = get_file (fd);
 
-  if (file != NULL)
+  if (t->fd_table != NULL)
     {
-      file_close (file);
-      t->fd_table[fd] = NULL;
+      fd_table_close (t->fd_table, fd);
     }
 }
 
@@ -151,15 +164,21 @@ check_if_valid_args (const void *esp, int argc)
     }
 }
 
+/* Registers the `int $0x30' system call gate, which always works,
+   and the SYSENTER entry if the CPU supports it.  Both end up in
+   syscall_handler(). */
 void
 syscall_init (void)
 {
   intr_register_int (0x30, 3, INTR_ON, syscall_handler, "syscall");
+  sysenter_enabled = tss_init_sysenter (sysenter_entry);
   lock_init (&filesys_lock);
   rwlock_init(&rw_lock);
 }
 
-static void
+/* Dispatches the system call whose number and arguments are on the
+   user stack at F->esp, storing the result in F->eax. */
+void
 syscall_handler (struct intr_frame *f)
 {
 
@@ -233,11 +252,10 @@ syscall_handler (struct intr_frame *f)
       fd = *(int32_t *)(argv);
       buffer = *(void **)(argv + 4);
       size = *(unsigned *)(argv + 8);
-      page_load_buffer_pages(buffer, size, true);
-      check_if_valid_bytes (buffer, size);
       page_pin_pages(buffer, size, true);
+      check_if_valid_bytes (buffer, size);
       res = read (fd, buffer, size);
-      page_pin_pages(buffer, size, false);
+      page_unpin_pages(buffer, size);
       f->eax = res;
       break;
     case SYS_WRITE:
@@ -245,11 +263,10 @@ syscall_handler (struct intr_frame *f)
       fd = *(int32_t *)(argv);
       buffer = *(void **)(argv + 4);
       size = *(unsigned *)(argv + 8);
-      page_load_buffer_pages(buffer, size, false);
+      page_pin_pages(buffer, size, false);
       check_if_valid_bytes (buffer, size);
-      page_pin_pages(buffer, size, true);
       res = write (fd, buffer, size);
-      page_pin_pages(buffer, size, false);
+      page_unpin_pages(buffer, size);
       f->eax = res;
       break;
     case SYS_SEEK:
@@ -271,6 +288,16 @@ syscall_handler (struct intr_frame *f)
         close (fd);
         break;
       }
+    case SYS_MMAP:
+      check_if_valid_args (argv, 2);
+      fd = *(int32_t *)(argv);
+      res = mmap (fd, *(void **)(argv + 4));
+      f->eax = res;
+      break;
+    case SYS_MUNMAP:
+      check_if_valid_args (argv, 1);
+      munmap (*(mapid_t *)(argv));
+      break;
     case SYS_CHDIR:
       check_if_valid_args (argv, 1);
       dir = *(char **)(argv);
@@ -305,6 +332,76 @@ syscall_handler (struct intr_frame *f)
       res = inumber (fd);
       f->eax = res;
       break;
+    case SYS_AIO_READ:
+    case SYS_AIO_WRITE:
+      check_if_valid_args (argv, 3);
+      fd = *(int32_t *)(argv);
+      buffer = *(void **)(argv + 4);
+      size = *(unsigned *)(argv + 8);
+      res = aio_submit (syscall_number == SYS_AIO_READ ? AIO_READ : AIO_WRITE,
+                        fd, buffer, size);
+      f->eax = res;
+      break;
+    case SYS_AIO_WAIT:
+      check_if_valid_args (argv, 1);
+      res = aio_wait (*(int32_t *)(argv));
+      f->eax = res;
+      break;
+    case SYS_AIO_POLL:
+      check_if_valid_args (argv, 1);
+      res = aio_poll (*(int32_t *)(argv));
+      f->eax = res;
+      break;
+    case SYS_SYSENTER:
+      f->eax = sysenter_enabled;
+      break;
+    case SYS_PIPE:
+      check_if_valid_args (argv, 1);
+      buffer = *(void **)(argv);
+      page_pin_pages(buffer, 2 * sizeof (int), true);
+      check_if_valid_bytes (buffer, 2 * sizeof (int));
+      res = pipe (buffer);
+      page_unpin_pages(buffer, 2 * sizeof (int));
+      f->eax = res;
+      break;
+    case SYS_DUP2:
+      check_if_valid_args (argv, 2);
+      fd = *(int32_t *)(argv);
+      res = dup2 (fd, *(int32_t *)(argv + 4));
+      f->eax = res;
+      break;
+    case SYS_SHM_OPEN:
+      check_if_valid_args (argv, 2);
+      file = *(char **)(argv);
+      check_if_valid_string (file);
+      res = shm_open (file, *(unsigned *)(argv + 4));
+      f->eax = res;
+      break;
+    case SYS_SHM_MAP:
+      check_if_valid_args (argv, 2);
+      f->eax = (uint32_t) shm_map (*(int32_t *)(argv), *(void **)(argv + 4));
+      break;
+    case SYS_SHM_UNMAP:
+      check_if_valid_args (argv, 1);
+      f->eax = shm_unmap (*(void **)(argv));
+      break;
+    case SYS_VMSTAT:
+      {
+        struct vmstat st;
+        check_if_valid_args (argv, 1);
+        buffer = *(void **)(argv);
+        page_pin_pages(buffer, sizeof st, true);
+        check_if_valid_bytes (buffer, sizeof st);
+        vmstat_get (&st);
+        memcpy (buffer, &st, sizeof st);
+        page_unpin_pages(buffer, sizeof st);
+        break;
+      }
+    case SYS_MADVISE:
+      check_if_valid_args (argv, 3);
+      f->eax = page_advise (*(void **)(argv), *(unsigned *)(argv + 4),
+                            *(int32_t *)(argv + 8)) ? 0 : -1;
+      break;
     default:
       PANIC ("Unknown system call");
       break;
@@ -372,6 +469,10 @@ remove (const char *file)
   status = filesys_remove (file);
   lock_release (&filesys_lock);
 
+  /* Let go of the file if it was a cached executable */
+  if (status)
+    elf_cache_drop_removed ();
+
   return status;
 }
 
@@ -389,10 +490,10 @@ open (const char *file)
 
   if (open_file != NULL)
     {
-      fd = allocate_fd ();
-      if (fd != -1)
+      fd = fd_table_add (t->fd_table, FD_FILE, open_file);
+      if (fd == -1)
         {
-          t->fd_table[fd] = open_file;
+          file_close (open_file);
         }
     }
 
@@ -419,14 +520,20 @@ filesize (int fd)
   return size;
 }
 
-/* Reads size bytes from file open as fd into buffer and returns the number of
-   bytes actually read. Fd of 0 will read from the keyboard*/
+/* Reads size bytes from file or pipe open as fd into buffer and returns the
+   number of bytes actually read. Fd of 0 will read from the keyboard unless it
+   has been redirected */
 int
 read (int fd, void *buffer, unsigned size)
 {
   int status = -1;
+  struct pipe *pipe = get_pipe (fd, FD_PIPE_READ);
 
-  if (fd == STDIN_FILE)
+  if (pipe != NULL)
+    {
+      status = pipe_read (pipe, buffer, size);
+    }
+  else if (fd == STDIN_FILE && get_file (fd) == NULL)
     {
       uint8_t *read_buffer = buffer;
       uint8_t key;
@@ -458,14 +565,20 @@ read (int fd, void *buffer, unsigned size)
   return status;
 }
 
-/* Writes size bytes from buffer to open file fd and returns the number of
-   bytes actually written. Fd of 1 will write to the console*/
+/* Writes size bytes from buffer to open file or pipe fd and returns the number
+   of bytes actually written. Fd of 1 will write to the console unless it has
+   been redirected */
 int
 write (int fd, const void *buffer, unsigned size)
 {
   int status = -1;
+  struct pipe *pipe = get_pipe (fd, FD_PIPE_WRITE);
 
-  if (fd == STDOUT_FILE)
+  if (pipe != NULL)
+    {
+      status = pipe_write (pipe, buffer, size);
+    }
+  else if (fd == STDOUT_FILE && get_file (fd) == NULL)
     {
       putbuf (buffer, size);
       return size;
@@ -529,6 +642,45 @@ close (int fd)
   lock_release (&filesys_lock);
 }
 
+/* Maps the file open as fd into the process's address space at addr.
+   The mapping stays valid after fd is closed.  Returns the mapping's id,
+   or MAP_FAILED if the file or the address cannot be mapped. */
+mapid_t
+mmap (int fd, void *addr)
+{
+  struct file *file = NULL;
+  mapid_t mapping;
+
+  lock_acquire (&filesys_lock);
+  struct file *open_file = get_file (fd);
+  if (open_file != NULL && !file_is_dir (open_file))
+    {
+      file = file_reopen (open_file);
+    }
+  lock_release (&filesys_lock);
+
+  if (file == NULL)
+    {
+      return MAP_FAILED;
+    }
+
+  mapping = mmap_map (file, addr);
+  if (mapping == MAP_FAILED)
+    {
+      lock_acquire (&filesys_lock);
+      file_close (file);
+      lock_release (&filesys_lock);
+    }
+  return mapping;
+}
+
+/* Unmaps mapping, writing the pages that were changed back to the file */
+void
+munmap (mapid_t mapping)
+{
+  mmap_unmap (mapping);
+}
+
 /* Changes the current working directory of the process to dir */
 bool
 chdir (const char *dir)
@@ -624,4 +776,52 @@ inumber (int fd)
     }
   lock_release (&filesys_lock);
   return status;
-}
\ No newline at end of file
+}
+/* Creates a pipe and stores the descriptors of its read and write ends in
+   fds[0] and fds[1].  Returns 0 if successful, -1 otherwise. */
+int
+pipe (int *fds)
+{
+  struct thread *t = thread_current ();
+  struct pipe *p = pipe_create ();
+  int read_fd, write_fd;
+
+  if (p == NULL)
+    {
+      return -1;
+    }
+
+  read_fd = fd_table_add (t->fd_table, FD_PIPE_READ, p);
+  if (read_fd == -1)
+    {
+      pipe_close_end (p, false);
+      pipe_close_end (p, true);
+      return -1;
+    }
+  write_fd = fd_table_add (t->fd_table, FD_PIPE_WRITE, p);
+  if (write_fd == -1)
+    {
+      fd_table_close (t->fd_table, read_fd);
+      pipe_close_end (p, true);
+      return -1;
+    }
+
+  fds[0] = read_fd;
+  fds[1] = write_fd;
+  return 0;
+}
+
+/* Makes newfd refer to the file or pipe end open as oldfd, closing newfd
+   first.  Redirecting fd 0 or 1 replaces the console until newfd is closed.
+   Returns newfd, or -1 if oldfd is not open or newfd cannot be used. */
+int
+dup2 (int oldfd, int newfd)
+{
+  bool success;
+
+  lock_acquire (&filesys_lock);
+  success = fd_table_dup2 (thread_current ()->fd_table, oldfd, newfd);
+  lock_release (&filesys_lock);
+
+  return success ? newfd : -1;
+}
@@ -6,9 +6,14 @@
 #define STDOUT_FILE 1
 
 
+struct intr_frame;
+
 void syscall_init (void);
+void syscall_handler (struct intr_frame *);
 void close (int fd); 
 
 struct lock *get_filesys_lock(void);
+struct rw_lock *get_rw_lock (void);
+struct file *get_file (int fd);
 
 #endif /* userprog/syscall.h */
@@ -2,6 +2,7 @@
 #include <debug.h>
 #include <stddef.h>
 #include "userprog/gdt.h"
+#include "threads/cpu.h"
 #include "threads/thread.h"
 #include "threads/palloc.h"
 #include "threads/vaddr.h"
@@ -104,3 +105,36 @@ tss_update (void)
   ASSERT (tss != NULL);
   tss->esp0 = (uint8_t *) thread_current () + PGSIZE;
 }
+
+/* Sets up the SYSENTER fast system call entry to jump to ENTRY.
+   SYSENTER loads %esp from an MSR that cannot follow context
+   switches, so we point it at the esp0 slot of the TSS instead
+   and ENTRY fetches the running thread's kernel stack from
+   there.  tss_update() thus keeps both entry paths current.
+   Returns false, leaving SYSENTER disabled, if the CPU does not
+   support it.  See [IA32-v3a] 4.8.7 "Performing Fast Calls to
+   System Procedures with the SYSENTER and SYSEXIT Instructions". */
+bool
+tss_init_sysenter (void (*entry) (void))
+{
+  uint32_t regs[4];
+  unsigned family, model, stepping;
+
+  ASSERT (tss != NULL);
+
+  cpuid (1, regs);
+  if ((regs[3] & CPUID_SEP) == 0)
+    return false;
+
+  /* The Pentium Pro reports SEP but does not implement it. */
+  family = (regs[0] >> 8) & 0xf;
+  model = (regs[0] >> 4) & 0xf;
+  stepping = regs[0] & 0xf;
+  if (family == 6 && model < 3 && stepping < 3)
+    return false;
+
+  wrmsr (MSR_SYSENTER_CS, SEL_KCSEG);
+  wrmsr (MSR_SYSENTER_ESP, (uint32_t) &tss->esp0);
+  wrmsr (MSR_SYSENTER_EIP, (uint32_t) entry);
+  return true;
+}
@@ -0,0 +1,234 @@
+#include "vm/code.h"
+#include <debug.h>
+#include <hash.h>
+#include <list.h>
+#include "filesys/file.h"
+#include "filesys/off_t.h"
+#include "threads/malloc.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "userprog/pagedir.h"
+#include "vm/frame.h"
+#include "vm/page.h"
+#include "vm/vmstat.h"
+
+/* A resident page of an executable. */
+struct code_frame
+{
+  off_t ofs;                  /* Offset of the page in the executable. */
+  struct frame *frame;        /* Frame holding it. */
+  struct hash_elem elem;      /* For the code table's frames. */
+};
+
+/* The resident read-only pages of one executable.
+   Every process running the executable maps the same frames, so a
+   second exec of a program finds its code already in memory.  A
+   table goes away with its last frame. */
+struct code_table
+{
+  struct inode *inode;        /* Executable. */
+  struct hash frames;         /* Resident struct code_frame, by ofs. */
+  struct list_elem elem;      /* For code_tables. */
+};
+
+/* All code tables, and the lock that guards them and is the table
+   lock of every frame in them. */
+static struct list code_tables;
+static struct lock code_lock;
+
+/* Returns a hash value for code frame f. */
+static unsigned
+code_frame_hash(const struct hash_elem *f_, void *aux UNUSED)
+{
+  const struct code_frame *f = hash_entry(f_, struct code_frame, elem);
+  return hash_int(f->ofs);
+}
+
+/* Returns true if code frame a precedes code frame b. */
+static bool
+code_frame_less(const struct hash_elem *a_, const struct hash_elem *b_,
+                void *aux UNUSED)
+{
+  const struct code_frame *a = hash_entry(a_, struct code_frame, elem);
+  const struct code_frame *b = hash_entry(b_, struct code_frame, elem);
+  return a->ofs < b->ofs;
+}
+
+/* Initializes the code tables. */
+void code_init(void)
+{
+  list_init(&code_tables);
+  lock_init(&code_lock);
+}
+
+/* Returns true if page p holds read-only contents of an executable,
+   which are the same for every process and so are shared. */
+bool code_is_shared(const struct page *p)
+{
+  return !p->writable && p->file != NULL && p->type != VM_FILE;
+}
+
+/* Returns the code table of inode, creating it if create is true.
+   Returns NULL if there is none or memory runs out.  Caller holds
+   code_lock. */
+static struct code_table *
+code_table_get(struct inode *inode, bool create)
+{
+  struct code_table *t;
+  struct list_elem *e;
+
+  for (e = list_begin(&code_tables); e != list_end(&code_tables); e = list_next(e))
+  {
+    t = list_entry(e, struct code_table, elem);
+    if (t->inode == inode)
+      return t;
+  }
+  if (!create)
+    return NULL;
+
+  t = malloc(sizeof *t);
+  if (t == NULL)
+    return NULL;
+  if (!hash_init(&t->frames, code_frame_hash, code_frame_less, NULL))
+  {
+    free(t);
+    return NULL;
+  }
+  t->inode = inode;
+  list_push_back(&code_tables, &t->elem);
+  return t;
+}
+
+/* Returns the entry for the page of page p's executable that p maps,
+   or NULL if it is not resident.  Caller holds code_lock. */
+static struct code_frame *
+code_lookup(struct page *p)
+{
+  struct code_table *t = code_table_get(file_get_inode(p->file), false);
+  struct code_frame key;
+  struct hash_elem *e;
+
+  if (t == NULL)
+    return NULL;
+  key.ofs = p->ofs;
+  e = hash_find(&t->frames, &key.elem);
+  return e != NULL ? hash_entry(e, struct code_frame, elem) : NULL;
+}
+
+/* Drops the entry for the page of page p's executable, and its table
+   if that was the last entry.  Caller holds code_lock. */
+static void
+code_forget(struct page *p)
+{
+  struct code_table *t = code_table_get(file_get_inode(p->file), false);
+  struct code_frame *f = code_lookup(p);
+
+  if (f == NULL)
+    return;
+  hash_delete(&t->frames, &f->elem);
+  free(f);
+  if (hash_empty(&t->frames))
+  {
+    list_remove(&t->elem);
+    hash_destroy(&t->frames, NULL);
+    free(t);
+  }
+}
+
+/* Maps shared page p, whose lock the caller holds, read-only to the
+   resident frame holding its contents, reading them in first if no
+   process has.  If prefault is true, only reads into a free frame.
+   Returns false if the page cannot be read or mapped. */
+bool code_load(struct page *p, bool prefault)
+{
+  struct code_frame *f;
+  struct frame *frame, *spare = NULL;
+  bool success;
+
+  lock_acquire(&code_lock);
+  f = code_lookup(p);
+  if (f == NULL)
+  {
+    /* Getting a frame may evict one of the shared ones, and reading
+       takes a while, so drop the lock meanwhile. */
+    lock_release(&code_lock);
+    spare = prefault ? frame_try_get_frame(PAL_USER) : frame_get_frame(PAL_USER);
+    if (spare == NULL)
+      return false;
+    if (!page_read_file(p, spare->kaddr))
+    {
+      frame_free_frame(spare);
+      return false;
+    }
+    vmstat_count(VMSTAT_FILE_FAULT);
+    lock_acquire(&code_lock);
+    f = code_lookup(p);
+  }
+
+  if (f != NULL)
+    frame = f->frame;
+  else
+  {
+    struct code_table *t = code_table_get(file_get_inode(p->file), true);
+    f = malloc(sizeof *f);
+    frame = spare;
+    spare = NULL;
+    if (t != NULL && f != NULL)
+    {
+      f->ofs = p->ofs;
+      f->frame = frame;
+      hash_insert(&t->frames, &f->elem);
+      frame->table_lock = &code_lock;
+    }
+    else
+    {
+      /* Out of memory for the table: keep the frame private. */
+      free(f);
+      if (t != NULL && hash_empty(&t->frames))
+      {
+        list_remove(&t->elem);
+        hash_destroy(&t->frames, NULL);
+        free(t);
+      }
+    }
+  }
+
+  frame_attach(frame, p);
+  success = pagedir_set_page(p->thread->pagedir, p->vaddr, frame->kaddr, false);
+  if (success)
+    pagedir_set_accessed(p->thread->pagedir, p->vaddr, true);
+  lock_release(&code_lock);
+
+  if (!success)
+    code_unmap(p);
+  if (spare != NULL)
+    frame_free_frame(spare);
+  return success;
+}
+
+/* Unmaps shared page p, whose lock the caller holds, from its frame,
+   and frees the frame if no other process maps it. */
+void code_unmap(struct page *p)
+{
+  struct frame *frame = p->frame;
+
+  lock_acquire(&code_lock);
+  if (frame_detach(frame, p) == 0)
+  {
+    if (frame->table_lock != NULL)
+      code_forget(p);
+    frame_free_frame(frame);
+  }
+  lock_release(&code_lock);
+}
+
+/* Forgets the frame of shared page p, which is being evicted.  The
+   caller holds code_lock, as the frame's table lock, unless the frame
+   was never entered in a table. */
+void code_evict(struct page *p)
+{
+  if (p->frame->table_lock == NULL)
+    return;
+  ASSERT(lock_held_by_current_thread(&code_lock));
+  code_forget(p);
+}
@@ -0,0 +1,14 @@
+#ifndef VM_CODE_H
+#define VM_CODE_H
+
+#include <stdbool.h>
+
+struct page;
+
+void code_init(void);
+bool code_is_shared(const struct page *p);
+bool code_load(struct page *p, bool prefault);
+void code_unmap(struct page *p);
+void code_evict(struct page *p);
+
+#endif /* vm/code.h */
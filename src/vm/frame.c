@@ -2,152 +2,662 @@
 #include "threads/thread.h"
 #include "vm/page.h"
 #include "vm/swap.h"
+#include <round.h>
 #include <stdlib.h>
+#include "threads/interrupt.h"
+#include "threads/vaddr.h"
 #include "userprog/pagedir.h"
+#include "vm/code.h"
+#include "vm/shm.h"
+#include "vm/vmstat.h"
 #include "vm/swap.h"
 
-struct list frame_table;
-struct lock frame_lock;
-struct semaphore io_sema;
+/* The frame table: one entry per page of the user pool, indexed by
+   its page number within the pool.  There is no lock over the whole
+   table.  Each entry's lock guards its state, and the clock only
+   ever tries those locks, so concurrent faults contend only on the
+   frames they look at. */
+static struct frame *frame_table;
+static size_t frame_cnt;
+static void *frame_base;
 
-struct list_elem *last_frame;
+/* Index of the next frame the clock looks at.  Scanners take frames
+   from it one at a time with interrupts off, so two scans running at
+   once look at different frames. */
+static size_t clock_hand;
 
-/* Wait for I/O to complete. */
-void frame_io_wait(void)
+/* Free pages left in the user pool.  When allocation takes it below
+   frame_low_water, the page-out daemon evicts frames until it is back
+   to frame_high_water, so that faults rarely have to evict.  Changed
+   with interrupts off. */
+static size_t frame_free_cnt;
+static size_t frame_low_water;
+static size_t frame_high_water;
+
+/* Page-out daemon: woken through pageout_sema, busy while
+   pageout_running, which is changed with interrupts off. */
+static struct semaphore pageout_sema;
+static bool pageout_running;
+
+/* Replacement policy.  Under FRAME_AGING, the timer has the page-out
+   daemon shift every frame's age right and set its top bit if the
+   frame was accessed since, every FRAME_AGE_TICKS ticks. */
+static enum frame_policy frame_policy;
+static unsigned frame_ticks;
+static bool frame_age_due;
+
+/* Age of a frame that was just used. */
+#define FRAME_AGE_REFERENCED 0x80
+
+static struct frame *frame_get_evicted_frame(void);
+static struct frame *frame_scan(size_t steps);
+static void frame_evict(struct frame *frame);
+static bool frame_unmap(struct frame *frame);
+static void frame_evict_done(struct frame *frame);
+static struct page *frame_first_page(struct frame *frame);
+static bool frame_test_and_clear_accessed(struct frame *frame);
+static void frame_unlock_all(struct frame *frame);
+
+/* Initialize the frame table and lock.  The table is allocated
+   once, with an entry for every page of the user pool. */
+void frame_init(enum frame_policy policy)
+{
+	size_t i;
+
+	palloc_user_pool(&frame_base, &frame_cnt);
+	frame_table = palloc_get_multiple(PAL_ASSERT | PAL_ZERO,
+									  DIV_ROUND_UP(frame_cnt * sizeof *frame_table, PGSIZE));
+	for (i = 0; i < frame_cnt; i++)
+	{
+		frame_table[i].kaddr = frame_base + i * PGSIZE;
+		list_init(&frame_table[i].pages);
+		lock_init(&frame_table[i].lock);
+	}
+
+	frame_free_cnt = frame_cnt;
+	frame_low_water = frame_cnt / 32 + 1;
+	frame_high_water = 2 * frame_low_water;
+	sema_init(&pageout_sema, 0);
+	frame_policy = policy;
+}
+
+/* Called by the timer interrupt on every tick.  Under the aging
+   policy, has the page-out daemon age the frames every
+   FRAME_AGE_TICKS ticks. */
+void frame_tick(void)
+{
+	if (frame_policy == FRAME_AGING && ++frame_ticks >= FRAME_AGE_TICKS)
+	{
+		frame_ticks = 0;
+		frame_age_due = true;
+		sema_up(&pageout_sema);
+	}
+}
+
+/* Wake the page-out daemon unless it is already running. */
+static void
+frame_pageout_wake(void)
 {
-	sema_down(&io_sema);
+	enum intr_level old_level = intr_disable();
+	if (!pageout_running)
+	{
+		pageout_running = true;
+		sema_up(&pageout_sema);
+	}
+	intr_set_level(old_level);
 }
 
-/* I/O is done. */
-void frame_io_done(void)
+/* Returns the frame under the clock hand and advances the hand. */
+static struct frame *
+frame_clock_next(void)
 {
-	sema_up(&io_sema);
+	enum intr_level old_level = intr_disable();
+	struct frame *frame = &frame_table[clock_hand];
+	clock_hand = (clock_hand + 1) % frame_cnt;
+	intr_set_level(old_level);
+	return frame;
 }
 
-/* Initialize the frame table and lock. */
-void frame_init(void)
+/* Age every frame in use: shift its age right, and set the top bit
+   if any page mapping it was accessed since the last pass.  Frames
+   that are busy keep their age until the next pass. */
+static void
+frame_age_all(void)
 {
-	list_init(&frame_table);
-	lock_init(&frame_lock);
-	sema_init(&io_sema, 1);
+	size_t i;
+
+	for (i = 0; i < frame_cnt; i++)
+	{
+		struct frame *frame = &frame_table[i];
+		if (!frame->used || !lock_try_acquire(&frame->lock))
+			continue;
+		if (frame->used && frame->ref_cnt > 0)
+		{
+			bool accessed = frame_test_and_clear_accessed(frame);
+			frame->age = (frame->age >> 1) | (accessed ? FRAME_AGE_REFERENCED : 0);
+		}
+		lock_release(&frame->lock);
+	}
 }
 
-/* Returns true if a frame is equal to the given kernel address. */
-bool frame_is_equal(const struct list_elem *a, const struct list_elem *b,
-					void *aux)
+/* Returns true if the page of frame A goes before that of frame B in
+   swap: grouped by process, then by address. */
+static bool
+frame_swap_less(struct frame *a, struct frame *b)
 {
-	struct frame *frame = list_entry(a, struct frame, elem);
-	void *kaddr = aux;
-	return frame->kaddr == kaddr;
+	struct page *pa = frame_first_page(a);
+	struct page *pb = frame_first_page(b);
+	if (pa->thread != pb->thread)
+		return pa->thread < pb->thread;
+	return pa->vaddr < pb->vaddr;
 }
 
-/* Free the frame and remove it from the frame table. */
-void frame_free_frame(struct frame *entry)
+/* Evict up to WANT frames and return their pages to the user pool,
+   starting with pages read ahead from swap.  Frames whose contents go
+   to swap are written together, each process's pages in address
+   order to contiguous swap slots where possible.  Returns the number
+   of frames freed, which is less than WANT only if no more can be
+   evicted now. */
+static size_t
+frame_pageout(size_t want)
 {
-	lock_acquire(&frame_lock);
-	lock_acquire(&entry->lock);
-	if (list_find(&frame_table, NULL, &frame_is_equal, entry->kaddr))
+	struct frame *cluster[SWAP_CLUSTER];
+	void *kaddrs[SWAP_CLUSTER];
+	block_sector_t swap_ids[SWAP_CLUSTER];
+	size_t done = swap_cache_shrink(want), cnt = 0, i, j;
+
+	while (done + cnt < want && cnt < SWAP_CLUSTER)
+	{
+		struct frame *frame = frame_scan(2 * frame_cnt);
+		if (frame == NULL)
+			break;
+		if (frame_unmap(frame))
+		{
+			/* Keep the cluster sorted */
+			for (i = cnt++; i > 0 && frame_swap_less(frame, cluster[i - 1]); i--)
+				cluster[i] = cluster[i - 1];
+			cluster[i] = frame;
+		}
+		else
+		{
+			frame_evict_done(frame);
+			lock_release(&frame->lock);
+			frame_free_frame(frame);
+			done++;
+		}
+	}
+
+	/* Write each process's run of pages in one go */
+	for (i = 0; i < cnt; i = j)
+	{
+		struct thread *owner = frame_first_page(cluster[i])->thread;
+		for (j = i; j < cnt && frame_first_page(cluster[j])->thread == owner; j++)
+			kaddrs[j] = cluster[j]->kaddr;
+		swap_out_cluster(kaddrs + i, j - i, owner, swap_ids + i);
+	}
+	for (i = 0; i < cnt; i++)
+	{
+		struct page *page = frame_first_page(cluster[i]);
+		page->swap_id = swap_ids[i];
+		page->swapped = true;
+		frame_evict_done(cluster[i]);
+		lock_release(&cluster[i]->lock);
+		frame_free_frame(cluster[i]);
+	}
+	return done + cnt;
+}
+
+/* Page-out daemon.  Each time it is woken, evicts frames and returns
+   their pages to the user pool until frame_high_water pages are
+   free, writing dirty contents out ahead of the faults that would
+   otherwise have to. */
+static void
+frame_pageout_daemon(void *aux UNUSED)
+{
+	for (;;)
 	{
-		list_remove(&entry->elem);
-		void *kaddr = entry->kaddr;
-		palloc_free_page(kaddr);
+		sema_down(&pageout_sema);
+		if (frame_age_due)
+		{
+			frame_age_due = false;
+			frame_age_all();
+		}
+		for (;;)
+		{
+			size_t free_cnt = frame_free_cnt;
+			size_t want = free_cnt < frame_high_water ? frame_high_water - free_cnt : 0;
+
+			/* Give up until the next wakeup if nothing can go */
+			if (want == 0 || frame_pageout(want) < want)
+			{
+				enum intr_level old_level = intr_disable();
+				pageout_running = false;
+				intr_set_level(old_level);
+				break;
+			}
+		}
 	}
-	entry->page->frame = NULL;
+}
 
-	free(entry);
-	lock_release(&frame_lock);
+/* Start the page-out daemon.  Must run after swap_init(). */
+void frame_pageout_init(void)
+{
+	thread_create("pageout", PRI_DEFAULT, frame_pageout_daemon, NULL);
 }
 
-/* Initialize a frame with the given kernel address. */
+/* Returns the frame table entry for the user pool page at KADDR, or
+   NULL if KADDR is not in the user pool. */
 struct frame *
+frame_lookup(void *kaddr)
+{
+	size_t idx = pg_no(kaddr) - pg_no(frame_base);
+	return kaddr >= frame_base && idx < frame_cnt ? &frame_table[idx] : NULL;
+}
+
+/* Returns the number of frames in the user pool. */
+size_t frame_total_cnt(void)
+{
+	return frame_cnt;
+}
+
+/* Returns the number of frames of the user pool in use. */
+size_t frame_used_cnt(void)
+{
+	return frame_cnt - frame_free_cnt;
+}
+
+/* Free the frame and return its page to the user pool. */
+void frame_free_frame(struct frame *entry)
+{
+	enum intr_level old_level;
+
+	lock_acquire(&entry->lock);
+	ASSERT(entry->used);
+	while (!list_empty(&entry->pages))
+	{
+		struct page *page = list_entry(list_pop_front(&entry->pages), struct page, frame_elem);
+		page->frame = NULL;
+	}
+	entry->ref_cnt = 0;
+	entry->table_lock = NULL;
+	entry->used = false;
+	old_level = intr_disable();
+	frame_free_cnt++;
+	intr_set_level(old_level);
+	palloc_free_page(entry->kaddr);
+	lock_release(&entry->lock);
+}
+
+/* Mark the frame of the newly allocated user page at KADDR as used. */
+static struct frame *
 frame_init_frame(void *kaddr)
 {
-	struct frame *entry = calloc(1, sizeof(struct frame));
-	entry->kaddr = kaddr;
-	entry->page = NULL;
-	lock_init(&entry->lock);
+	struct frame *entry = frame_lookup(kaddr);
+	enum intr_level old_level;
+	bool low;
+
+	ASSERT(entry != NULL);
+
+	lock_acquire(&entry->lock);
+	ASSERT(!entry->used && entry->ref_cnt == 0);
+	entry->table_lock = NULL;
+	entry->age = FRAME_AGE_REFERENCED;
+	entry->used = true;
+	lock_release(&entry->lock);
 
-	lock_acquire(&frame_lock);
-	list_push_back(&frame_table, &entry->elem);
-	lock_release(&frame_lock);
+	old_level = intr_disable();
+	low = --frame_free_cnt < frame_low_water;
+	intr_set_level(old_level);
+	if (low)
+		frame_pageout_wake();
 
 	return entry;
 }
 
-/* Find a frame that can be evicted. */
-struct frame *
-frame_get_evicted_frame(void)
+/* Map PAGE to FRAME in addition to any pages already mapped to it. */
+void frame_attach(struct frame *frame, struct page *page)
+{
+	lock_acquire(&frame->lock);
+	list_push_back(&frame->pages, &page->frame_elem);
+	frame->ref_cnt++;
+	page->frame = frame;
+	lock_release(&frame->lock);
+}
+
+/* Unmap PAGE from FRAME.  Returns the number of pages still mapped
+   to FRAME; the caller frees it when none are left and nothing else
+   holds it. */
+unsigned frame_detach(struct frame *frame, struct page *page)
+{
+	unsigned ref_cnt;
+
+	lock_acquire(&frame->lock);
+	list_remove(&page->frame_elem);
+	ref_cnt = --frame->ref_cnt;
+	page->frame = NULL;
+	lock_release(&frame->lock);
+	return ref_cnt;
+}
+
+/* Make FRAME, if no other page shares it, look unused since long ago,
+   so that it is among the first evicted. */
+void frame_deactivate(struct frame *frame)
+{
+	lock_acquire(&frame->lock);
+	if (frame->used && frame->ref_cnt == 1)
+	{
+		frame_test_and_clear_accessed(frame);
+		frame->age = 0;
+	}
+	lock_release(&frame->lock);
+}
+
+/* Returns the first page mapped to FRAME. */
+static struct page *
+frame_first_page(struct frame *frame)
+{
+	return list_entry(list_front(&frame->pages), struct page, frame_elem);
+}
+
+/* Release the locks of the pages mapped to FRAME, up to STOP. */
+static void
+frame_unlock_pages(struct frame *frame, struct list_elem *stop)
 {
-	bool flag = true;
 	struct list_elem *e;
-	struct frame *frame_to_remove;
-	struct page *page;
+	for (e = list_begin(&frame->pages); e != stop; e = list_next(e))
+		lock_release(&list_entry(e, struct page, frame_elem)->lock);
+}
+
+/* Try to lock every page mapped to FRAME, and the table that shares
+   FRAME between processes if there is one.  Returns false, with none
+   of them locked, if any of the locks is busy. */
+static bool
+frame_try_lock_pages(struct frame *frame)
+{
+	struct list_elem *e;
+	for (e = list_begin(&frame->pages); e != list_end(&frame->pages); e = list_next(e))
+	{
+		if (!lock_try_acquire(&list_entry(e, struct page, frame_elem)->lock))
+		{
+			frame_unlock_pages(frame, e);
+			return false;
+		}
+	}
+	if (frame->table_lock != NULL && !lock_try_acquire(frame->table_lock))
+	{
+		frame_unlock_pages(frame, list_end(&frame->pages));
+		return false;
+	}
+	return true;
+}
+
+/* Release the locks taken by frame_try_lock_pages(). */
+static void
+frame_unlock_all(struct frame *frame)
+{
+	if (frame->table_lock != NULL)
+		lock_release(frame->table_lock);
+	frame_unlock_pages(frame, list_end(&frame->pages));
+}
 
-	lock_acquire(&frame_lock);
+/* Returns true if any page mapped to FRAME is pinned. */
+static bool
+frame_is_pinned(struct frame *frame)
+{
+	struct list_elem *e;
+	for (e = list_begin(&frame->pages); e != list_end(&frame->pages); e = list_next(e))
+		if (list_entry(e, struct page, frame_elem)->pin_cnt > 0)
+			return true;
+	return false;
+}
+
+/* Returns true if any mapping of FRAME was accessed since the last
+   call, clearing every accessed bit. */
+static bool
+frame_test_and_clear_accessed(struct frame *frame)
+{
+	bool accessed = false;
+	struct list_elem *e;
+	for (e = list_begin(&frame->pages); e != list_end(&frame->pages); e = list_next(e))
+	{
+		struct page *page = list_entry(e, struct page, frame_elem);
+		if (pagedir_is_accessed(page->thread->pagedir, page->vaddr))
+		{
+			pagedir_set_accessed(page->thread->pagedir, page->vaddr, false);
+			accessed = true;
+		}
+	}
+	return accessed;
+}
+
+/* Returns true if evicting FRAME, whose page locks are held, means
+   writing its contents somewhere, the same way frame_unmap() decides. */
+static bool
+frame_needs_write(struct frame *frame)
+{
+	struct page *page = frame_first_page(frame);
+	bool is_dirty = false;
+	struct list_elem *e;
 
-	bool found_frame_to_remove = false;
+	for (e = list_begin(&frame->pages); e != list_end(&frame->pages); e = list_next(e))
+	{
+		struct page *sharer = list_entry(e, struct page, frame_elem);
+		is_dirty |= pagedir_is_dirty(sharer->thread->pagedir, sharer->vaddr);
+	}
+	switch (page->type)
+	{
+	case VM_BIN:
+		return is_dirty || page->writable;
+	case VM_FILE:
+		return is_dirty;
+	default:
+		return true;
+	}
+}
 
-	// Start from the last frame if it's valid; otherwise, start from the beginning
-	e = (last_frame == NULL || last_frame == list_end(&frame_table)) ? list_front(&frame_table) : last_frame;
+/* Look at up to STEPS frames from the clock hand for one that can be
+   evicted.  Returns it with its lock, the locks of all pages mapped
+   to it and its table lock held, or NULL if none of them can be.
+   Takes no lock over the table and never waits for a lock, skipping
+   frames another thread is working on instead.
+   Under FRAME_CLOCK this is the first frame not accessed since the
+   hand last passed.  Under FRAME_AGING it is the oldest of the next
+   FRAME_SCAN_WINDOW such frames, a clean one winning a tie. */
+static struct frame *
+frame_scan(size_t steps)
+{
+	struct frame *frame_to_remove;
+	struct frame *best = NULL;
+	unsigned best_cost = 0;
+	size_t candidates = 0;
 
-	// Iterate over the frame table until a suitable frame is found
-	while (!found_frame_to_remove)
+	// Take frames from the clock hand, wrapping around, until a suitable frame is found
+	for (; steps > 0; steps--)
 	{
-		for (; e != list_end(&frame_table); e = list_next(e))
+		unsigned cost;
+
+		frame_to_remove = frame_clock_next();
+
+		// Skip pages of the user pool that are not allocated; a quick look, checked again under the lock
+		if (!frame_to_remove->used)
 		{
-			frame_to_remove = list_entry(e, struct frame, elem);
-			page = frame_to_remove->page;
+			continue;
+		}
 
-			// Attempt to acquire the lock for the current frame
-			if (!lock_try_acquire(&frame_to_remove->lock))
-			{
-				continue; // Skip this frame if the lock cannot be acquired
-			}
+		// Attempt to acquire the lock for the current frame
+		if (!lock_try_acquire(&frame_to_remove->lock))
+		{
+			continue; // Skip this frame if the lock cannot be acquired
+		}
 
-			// Attempt to acquire the lock for the current frame
-			if (!lock_try_acquire(&page->lock))
-			{
-				lock_release(&frame_to_remove->lock);
-				continue; // Skip this frame if the lock cannot be acquired
-			}
+		// Skip frames freed meanwhile, that belong to no page yet, or are held by a pipe or segment
+		if (!frame_to_remove->used || frame_to_remove->ref_cnt == 0)
+		{
+			lock_release(&frame_to_remove->lock);
+			continue;
+		}
 
-			// Check if the frame is pinned; if so, release the lock and skip it
-			if (page->pinned)
-			{
-				lock_release(&frame_to_remove->lock);
-				lock_release(&page->lock);
-				continue;
-			}
+		// Attempt to acquire the locks of every page mapped to the frame
+		if (!frame_try_lock_pages(frame_to_remove))
+		{
+			lock_release(&frame_to_remove->lock);
+			continue; // Skip this frame if a lock cannot be acquired
+		}
+
+		// Check if the frame is pinned; if so, release the locks and skip it
+		if (frame_is_pinned(frame_to_remove))
+		{
+			frame_unlock_all(frame_to_remove);
+			lock_release(&frame_to_remove->lock);
+			continue;
+		}
 
-			// Check if the page was accessed recently; if so, clear the accessed bit, release the lock, and skip it
-			if (pagedir_is_accessed(page->thread->pagedir, page->vaddr))
+		// Check if the frame was accessed recently through any mapping; if so, clear the accessed bits, make it young again, release the locks, and skip it
+		if (frame_test_and_clear_accessed(frame_to_remove))
+		{
+			frame_to_remove->age |= FRAME_AGE_REFERENCED;
+			frame_unlock_all(frame_to_remove);
+			lock_release(&frame_to_remove->lock);
+			continue;
+		}
+
+		// Under the clock policy, the first frame not accessed is the one to remove
+		if (frame_policy == FRAME_CLOCK)
+		{
+			best = frame_to_remove;
+			break;
+		}
+
+		// Under the aging policy, keep the cheapest frame seen so far: the oldest, and of those a clean one
+		cost = ((unsigned)frame_to_remove->age << 1) | frame_needs_write(frame_to_remove);
+		if (best == NULL || cost < best_cost)
+		{
+			if (best != NULL)
 			{
-				pagedir_set_accessed(page->thread->pagedir, page->vaddr, false);
-				lock_release(&frame_to_remove->lock);
-				lock_release(&page->lock);
-				continue;
+				frame_unlock_all(best);
+				lock_release(&best->lock);
 			}
-
-			// A suitable frame to remove has been found
-			found_frame_to_remove = true;
-			break; // Exit the loop
+			best = frame_to_remove;
+			best_cost = cost;
+		}
+		else
+		{
+			frame_unlock_all(frame_to_remove);
+			lock_release(&frame_to_remove->lock);
 		}
 
-		// If the end of the list is reached without finding a frame, start from the beginning
-		if (!found_frame_to_remove)
+		// Stop at a clean frame nobody used lately, or once the window is full
+		if (best_cost == 0 || ++candidates >= FRAME_SCAN_WINDOW)
 		{
-			e = list_front(&frame_table);
+			break;
 		}
 	}
-	last_frame = list_next(e);
-	lock_release(&frame_lock);
-	return frame_to_remove;
+	return best;
+}
+
+/* Find a frame that can be evicted, waiting for one if there is none.
+   Returns it with its lock, the locks of all pages mapped to it and
+   its table lock held. */
+static struct frame *
+frame_get_evicted_frame(void)
+{
+	struct frame *frame;
+
+	/* Two turns of the clock clear every accessed bit on the way */
+	while ((frame = frame_scan(2 * frame_cnt)) == NULL)
+		thread_yield();
+	return frame;
 }
 
 /* Reset the frame so that it can be used by another page. */
 void frame_reset_frame(struct frame *frame)
 {
-	frame->page = NULL;
+	while (!list_empty(&frame->pages))
+	{
+		struct page *page = list_entry(list_pop_front(&frame->pages), struct page, frame_elem);
+		page->frame = NULL;
+		lock_release(&page->lock);
+	}
+	frame->ref_cnt = 0;
+	frame->age = FRAME_AGE_REFERENCED;
+	if (frame->table_lock != NULL)
+	{
+		lock_release(frame->table_lock);
+		frame->table_lock = NULL;
+	}
+}
+
+/* Unmap FRAME, as returned by frame_get_evicted_frame(), from every
+   page that shares it and save its contents where they belong, unless
+   they go to swap.  Returns true if they do; the caller then writes
+   them there.  The page stays pinned until frame_evict_done(). */
+static bool
+frame_unmap(struct frame *frame_to_remove)
+{
+	struct page *page = frame_first_page(frame_to_remove);
+	bool is_dirty = false;
+	bool to_swap = false;
+	struct list_elem *e;
+
+	/* Unmap the frame from every page that shares it */
+	for (e = list_begin(&frame_to_remove->pages); e != list_end(&frame_to_remove->pages); e = list_next(e))
+	{
+		struct page *sharer = list_entry(e, struct page, frame_elem);
+		is_dirty |= pagedir_is_dirty(sharer->thread->pagedir, sharer->vaddr);
+		pagedir_clear_page(sharer->thread->pagedir, sharer->vaddr);
+	}
+	page->pin_cnt++;
+	/* Decide where the contents go */
+	switch (page->type)
+	{
+	case VM_BIN:
+		if (is_dirty || page->writable)
+			to_swap = true;
+		else if (code_is_shared(page))
+			code_evict(page);
+		break;
+
+	case VM_ANON:
+		to_swap = true;
+		break;
+
+	case VM_FILE:
+		/* Mapped files are written back to the file, never to swap */
+		if (is_dirty)
+			page_write_file(page);
+		break;
+
+	case VM_SHM:
+		/* The segment keeps the contents for all of its mappers */
+		shm_evict(page, frame_to_remove->kaddr);
+		break;
+	}
+	vmstat_count(to_swap || page->type == VM_SHM || (page->type == VM_FILE && is_dirty)
+		     ? VMSTAT_DIRTY_EVICT : VMSTAT_CLEAN_EVICT);
+	return to_swap;
+}
+
+/* Finish evicting FRAME: unpin its page and release the locks of its
+   pages.  FRAME's own lock stays held. */
+static void
+frame_evict_done(struct frame *frame)
+{
+	frame_first_page(frame)->pin_cnt--;
+	frame_reset_frame(frame);
+}
+
+/* Evict FRAME, as returned by frame_get_evicted_frame(), writing it to
+   swap if needed.  FRAME's own lock stays held. */
+static void
+frame_evict(struct frame *frame)
+{
+	if (frame_unmap(frame))
+	{
+		struct page *page = frame_first_page(frame);
+		page->swap_id = swap_out(frame->kaddr, page->thread);
+		page->swapped = true;
+	}
+	frame_evict_done(frame);
 }
 
 /* Get a frame by allocating a new page or evicting another page. */
@@ -157,8 +667,11 @@ frame_get_frame(enum palloc_flags flags)
 	struct frame *entry;
 	void *kaddr;
 
-	/* Allocate a new page. */
+	/* Allocate a new page, dropping a page read ahead from swap if
+	   there is no other */
 	kaddr = palloc_get_page(flags);
+	if (kaddr == NULL && swap_cache_shrink(1) > 0)
+		kaddr = palloc_get_page(flags);
 	if (kaddr != NULL)
 	{
 		entry = frame_init_frame(kaddr);
@@ -166,41 +679,54 @@ frame_get_frame(enum palloc_flags flags)
 
 	else
 	{
-		/* If not possible, evict another page */
-		struct frame *frame_to_remove = frame_get_evicted_frame();
-		struct page *page = frame_to_remove->page;
-		void *kaddr = frame_to_remove->kaddr;
-		bool is_dirty = pagedir_is_dirty(page->thread->pagedir, page->vaddr);
-		pagedir_clear_page(page->thread->pagedir, page->vaddr);
-		page->pinned = true;
-		/* Save the page to the swap space if needed */
-		switch (page->type)
-		{
-		case VM_BIN:
-			if (is_dirty || page->writable)
-			{
-				frame_io_wait();
-				page->swap_id = swap_out(kaddr);
-				frame_io_done();
-				page->swapped = true;
-			}
-			break;
-
-		case VM_ANON:
-			frame_io_wait();
-			page->swap_id = swap_out(kaddr);
-			frame_io_done();
-			page->swapped = true;
-			break;
-		}
-
-		page->frame = NULL;
-		frame_reset_frame(frame_to_remove);
-		entry = frame_to_remove;
-		page->pinned = false;
-		lock_release(&frame_to_remove->lock);
-		lock_release(&page->lock);
+		/* If not possible, evict another page, and have the page-out
+		   daemon free some ahead of the next fault */
+		frame_pageout_wake();
+		entry = frame_get_evicted_frame();
+		frame_evict(entry);
+		lock_release(&entry->lock);
 	}
 
 	return entry;
 }
+
+/* Get a frame only if a page is free, without evicting.  Returns NULL
+   if none is. */
+struct frame *
+frame_try_get_frame(enum palloc_flags flags)
+{
+	void *kaddr = palloc_get_page(flags);
+	if (kaddr == NULL)
+		return NULL;
+	return frame_init_frame(kaddr);
+}
+
+/* Get PAGE_CNT contiguous free frames, the first of them aligned to
+   PAGE_CNT pages, for a large page, without evicting.  The frames
+   belong to no page, so they are never evicted.  Returns the kernel
+   address of the first one, or NULL if no such block is free or it
+   would leave the pool short of free frames. */
+void *
+frame_get_huge(size_t page_cnt)
+{
+	void *kaddr;
+	size_t i;
+
+	if (frame_free_cnt < page_cnt + frame_high_water)
+		return NULL;
+	kaddr = palloc_get_aligned(PAL_USER | PAL_ZERO, page_cnt, page_cnt);
+	if (kaddr == NULL)
+		return NULL;
+	for (i = 0; i < page_cnt; i++)
+		frame_init_frame(kaddr + i * PGSIZE);
+	return kaddr;
+}
+
+/* Free the PAGE_CNT frames from KADDR got by frame_get_huge(). */
+void frame_free_huge(void *kaddr, size_t page_cnt)
+{
+	size_t i;
+
+	for (i = 0; i < page_cnt; i++)
+		frame_free_frame(frame_lookup(kaddr + i * PGSIZE));
+}
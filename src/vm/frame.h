@@ -2,20 +2,48 @@
 #define VM_FRAME_H
 #include "threads/palloc.h"
 #include <list.h>
+#include <stdint.h>
 #include "threads/synch.h"
 
+struct page;
+
+/* Page replacement policy. */
+enum frame_policy
+{
+	FRAME_CLOCK, /* Second chance on the accessed bit alone */
+	FRAME_AGING  /* Least recently used by age, clean before dirty */
+};
+
+/* Ticks between two aging passes over the frame table. */
+#define FRAME_AGE_TICKS 20
+
+/* Frames the aging policy looks at for the cheapest one to evict. */
+#define FRAME_SCAN_WINDOW 16
+
 struct frame
 {
 	void *kaddr;		   /* Kernel virtual address */
-	struct list_elem elem; /* List element for frame table list */
-	struct lock lock;	   /* Lock to prevent simultaneous changes to frames */
-	struct page *page;	   /* Page that is mapped to this frame */
+	bool used;		   /* True if the frame is allocated */
+	struct lock lock;	   /* Guards the frame; the clock only tries it */
+	struct list pages;	   /* Pages mapped to this frame */
+	unsigned ref_cnt;	   /* Number of pages in PAGES */
+	struct lock *table_lock;   /* Lock of the table that shares this frame, or NULL */
+	uint8_t age;		   /* Accessed bits of the last aging passes, newest highest */
 };
 
-void frame_init(void);
-void frame_io_wait(void);
-void frame_io_done(void);
+void frame_init(enum frame_policy policy);
+void frame_tick(void);
+void frame_pageout_init(void);
 struct frame *frame_get_frame(enum palloc_flags flags);
+struct frame *frame_try_get_frame(enum palloc_flags flags);
 void frame_free_frame(struct frame *entry);
+void *frame_get_huge(size_t page_cnt);
+void frame_free_huge(void *kaddr, size_t page_cnt);
+struct frame *frame_lookup(void *kaddr);
+size_t frame_total_cnt(void);
+size_t frame_used_cnt(void);
+void frame_attach(struct frame *frame, struct page *page);
+unsigned frame_detach(struct frame *frame, struct page *page);
+void frame_deactivate(struct frame *frame);
 
 #endif /* vm/frame.h */
\ No newline at end of file
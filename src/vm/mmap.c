@@ -0,0 +1,114 @@
+#include "vm/mmap.h"
+#include <debug.h>
+#include <list.h>
+#include <round.h>
+#include "filesys/file.h"
+#include "threads/malloc.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+#include "userprog/syscall.h"
+#include "vm/page.h"
+
+/* A file mapped into a process's address space.
+   Its pages are VM_FILE pages, read from the file on first touch
+   and written back to it, rather than to swap, when they are dirty
+   and get evicted or unmapped. */
+struct mmap_mapping
+{
+  mapid_t id;            /* Mapping identifier. */
+  struct file *file;     /* Private handle on the mapped file. */
+  void *addr;            /* Address of the first page. */
+  size_t page_cnt;       /* Number of pages. */
+  struct list_elem elem; /* For the thread's mmaps. */
+};
+
+/* Maps FILE, a handle the mapping takes over, at page-aligned ADDR in
+   the current process.  Returns the mapping's id, or MAP_FAILED if
+   FILE is empty or the range is unusable or overlaps any page. */
+mapid_t mmap_map(struct file *file, void *addr)
+{
+  struct thread *cur = thread_current();
+  struct mmap_mapping *m;
+  struct vma *v;
+  off_t length;
+
+  if (addr == NULL || pg_ofs(addr) != 0 || addr < (void *)VADDR_START
+      || !is_user_vaddr(addr))
+    return MAP_FAILED;
+
+  length = file_length(file);
+  if (length <= 0)
+    return MAP_FAILED;
+
+  m = malloc(sizeof *m);
+  if (m == NULL)
+    return MAP_FAILED;
+  m->file = file;
+  m->addr = addr;
+  m->page_cnt = DIV_ROUND_UP((size_t) length, PGSIZE);
+
+  /* Refuse to cover code, data, stack or another mapping. */
+  v = page_add_vma(addr, m->page_cnt, true);
+  if (v == NULL)
+  {
+    free(m);
+    return MAP_FAILED;
+  }
+  v->type = VM_FILE;
+  v->file = file;
+  v->file_bytes = length;
+
+  m->id = cur->mmap_next_id++;
+  list_push_back(&cur->mmaps, &m->elem);
+  return m->id;
+}
+
+/* Removes the pages of mapping M, which writes the dirty ones back,
+   then closes its file and frees it.  Returns false, keeping M, if
+   I/O in progress still has some of its pages pinned. */
+static bool
+mmap_destroy(struct mmap_mapping *m)
+{
+  struct lock *fs_lock = get_filesys_lock();
+
+  if (!page_remove_vma(m->addr))
+    return false;
+  list_remove(&m->elem);
+
+  lock_acquire(fs_lock);
+  file_close(m->file);
+  lock_release(fs_lock);
+  free(m);
+  return true;
+}
+
+/* Unmaps MAPPING of the current process.  Returns false if there is
+   no such mapping, or if I/O in progress still uses it. */
+bool mmap_unmap(mapid_t mapping)
+{
+  struct list *mmaps = &thread_current()->mmaps;
+  struct list_elem *e;
+
+  for (e = list_begin(mmaps); e != list_end(mmaps); e = list_next(e))
+  {
+    struct mmap_mapping *m = list_entry(e, struct mmap_mapping, elem);
+    if (m->id == mapping)
+      return mmap_destroy(m);
+  }
+  return false;
+}
+
+/* Unmaps every mapping of the exiting process, writing back what it
+   changed.  Must run before its supplemental page table goes away,
+   and after aio_exit(), which leaves no page pinned. */
+void mmap_exit(void)
+{
+  struct list *mmaps = &thread_current()->mmaps;
+
+  while (!list_empty(mmaps))
+  {
+    bool removed = mmap_destroy(list_entry(list_front(mmaps),
+                                           struct mmap_mapping, elem));
+    ASSERT(removed);
+  }
+}
@@ -0,0 +1,16 @@
+#ifndef VM_MMAP_H
+#define VM_MMAP_H
+
+#include <stdbool.h>
+
+struct file;
+
+/* Map region identifier. */
+typedef int mapid_t;
+#define MAP_FAILED ((mapid_t) -1)
+
+mapid_t mmap_map(struct file *file, void *addr);
+bool mmap_unmap(mapid_t mapping);
+void mmap_exit(void);
+
+#endif /* vm/mmap.h */
@@ -1,6 +1,9 @@
 #include "vm/page.h"
 #include "vm/swap.h"
 #include <debug.h>
+#include <round.h>
+#include <string.h>
+#include "filesys/file.h"
 #include "threads/thread.h"
 #include "vm/frame.h"
 #include "threads/vaddr.h"
@@ -8,6 +11,49 @@
 #include "threads/malloc.h"
 #include "vm/swap.h"
 #include "threads/synch.h"
+#include "vm/code.h"
+#include "vm/shm.h"
+#include "vm/vmstat.h"
+
+/* Page of zeros that every untouched anonymous page maps read-only
+   until it is first written. */
+static void *zero_page;
+
+/* Largest stack a process may have, in bytes. */
+static size_t stack_max = STACK_SIZE;
+
+/* True if large zero-filled regions get large pages. */
+static bool huge_pages;
+
+static struct page *page_get(void *addr);
+static bool page_prefault(struct page *q, bool write);
+static void page_release_huge(struct vma *v);
+void page_destroy(struct hash_elem *e, void *aux UNUSED);
+
+/* Allocates the zero page. */
+void page_zero_init(void)
+{
+  zero_page = palloc_get_page(PAL_ASSERT | PAL_ZERO);
+}
+
+/* Sets the largest stack a process may have to max bytes. */
+void page_stack_init(size_t max)
+{
+  stack_max = ROUND_UP(max, PGSIZE);
+}
+
+/* Maps whole, aligned 4 MB stretches of zero-filled memory of
+   processes with large pages from now on if enable is true. */
+void page_huge_init(bool enable)
+{
+  huge_pages = enable;
+}
+
+/* Returns true if processes get large pages. */
+bool page_huge_enabled(void)
+{
+  return huge_pages;
+}
 
 /* Returns a hash value for page p. */
 unsigned
@@ -32,7 +78,213 @@ bool page_init_table(void)
 {
   struct thread *t = thread_current();
   t->supl_pt = malloc(sizeof *t->supl_pt);
-  return t->supl_pt != NULL && hash_init(t->supl_pt, page_hash, page_less, NULL);
+  t->vmas = malloc(VMA_INIT_CNT * sizeof *t->vmas);
+  t->vma_cnt = 0;
+  t->vma_cap = t->vmas != NULL ? VMA_INIT_CNT : 0;
+  t->fault_around = FAULT_AROUND_INIT;
+  t->fault_around_lo = t->fault_around_hi = NULL;
+  t->stack_max = stack_max;
+  return t->supl_pt != NULL && t->vmas != NULL
+         && hash_init(t->supl_pt, page_hash, page_less, NULL);
+}
+
+/* Returns the index of the first region of the current process that
+   ends after addr, which is the region holding addr if any does. */
+static size_t page_vma_index(const void *addr)
+{
+  struct thread *t = thread_current();
+  size_t lo = 0, hi = t->vma_cnt;
+
+  while (lo < hi)
+  {
+    size_t mid = lo + (hi - lo) / 2;
+    if (t->vmas[mid].end <= addr)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  return lo;
+}
+
+/* Returns the region of the current process holding addr, or a null
+   pointer if there is none. */
+struct vma *page_vma_lookup(const void *addr)
+{
+  struct thread *t = thread_current();
+  size_t i = page_vma_index(addr);
+  return i < t->vma_cnt && t->vmas[i].start <= addr ? &t->vmas[i] : NULL;
+}
+
+/* Adds a region of page_cnt anonymous pages at page-aligned start to
+   the current process, for the caller to fill in.  The pointer stays
+   valid until regions are added or removed.  Returns a null pointer
+   if the range leaves user memory or overlaps another region, or if
+   memory runs out. */
+struct vma *page_add_vma(void *start, size_t page_cnt, bool writable)
+{
+  struct thread *t = thread_current();
+  struct vma *v;
+  size_t i;
+
+  ASSERT(pg_ofs(start) == 0);
+  if (page_cnt == 0 || !is_user_vaddr(start)
+      || (size_t)(PHYS_BASE - start) / PGSIZE < page_cnt)
+    return NULL;
+  i = page_vma_index(start);
+  if (i < t->vma_cnt && t->vmas[i].start < start + page_cnt * PGSIZE)
+    return NULL;
+
+  if (t->vma_cnt == t->vma_cap)
+  {
+    size_t cap = t->vma_cap * 2;
+    struct vma *vmas = realloc(t->vmas, cap * sizeof *vmas);
+    if (vmas == NULL)
+      return NULL;
+    t->vmas = vmas;
+    t->vma_cap = cap;
+  }
+  memmove(&t->vmas[i + 1], &t->vmas[i], (t->vma_cnt - i) * sizeof *t->vmas);
+  t->vma_cnt++;
+
+  v = &t->vmas[i];
+  v->start = start;
+  v->end = start + page_cnt * PGSIZE;
+  v->type = VM_ANON;
+  v->writable = writable;
+  v->file = NULL;
+  v->shm = NULL;
+  v->ofs = 0;
+  v->file_bytes = 0;
+  v->advice = MADV_NORMAL;
+  v->huge = false;
+  return v;
+}
+
+/* Adds a writable region of page_cnt zero-filled pages at start,
+   both multiples of HUGE_PAGE_SIZE, to the current process, and maps
+   all of it now with large pages of contiguous free frames.  A large
+   page takes one TLB entry instead of 1024.  Its frames belong to no
+   page, so they are never evicted, and stay until the region goes
+   away.  If the frames cannot be found, the region is paged as usual
+   instead.  Returns false if the region cannot be added. */
+bool page_add_huge(void *start, size_t page_cnt)
+{
+  uint32_t *pd = thread_current()->pagedir;
+  struct vma *v = page_add_vma(start, page_cnt, true);
+  void *upage;
+
+  ASSERT((uintptr_t)start % HUGE_PAGE_SIZE == 0);
+  ASSERT(page_cnt % (HUGE_PAGE_SIZE / PGSIZE) == 0);
+  if (v == NULL)
+    return false;
+
+  for (upage = start; upage < v->end; upage += HUGE_PAGE_SIZE)
+  {
+    void *kpage = frame_get_huge(HUGE_PAGE_SIZE / PGSIZE);
+    if (kpage == NULL)
+    {
+      /* Give back the large pages mapped so far */
+      v->end = upage;
+      page_release_huge(v);
+      v->end = start + page_cnt * PGSIZE;
+      return true;
+    }
+    pagedir_set_huge(pd, upage, kpage, true);
+  }
+  v->huge = true;
+  return true;
+}
+
+/* Unmaps the large pages of region v, from its start up to its end,
+   and frees their frames.  The region then has no pages loaded. */
+static void page_release_huge(struct vma *v)
+{
+  uint32_t *pd = thread_current()->pagedir;
+  void *upage;
+
+  for (upage = v->start; upage < v->end; upage += HUGE_PAGE_SIZE)
+    frame_free_huge(pagedir_clear_huge(pd, upage), HUGE_PAGE_SIZE / PGSIZE);
+  v->huge = false;
+}
+
+/* Returns the lowest address the stack of the current process may
+   grow down to. */
+void *page_stack_limit(void)
+{
+  return PHYS_BASE - thread_current()->stack_max;
+}
+
+/* Adds the stack of the current process, which may grow to hint
+   bytes if hint is not 0 and the boot limit allows, and loads its
+   top page_cnt pages, at least the topmost.  Returns false if memory
+   runs out. */
+bool page_add_stack(size_t hint, size_t page_cnt)
+{
+  struct thread *t = thread_current();
+  void *top = PHYS_BASE - PGSIZE;
+  void *vaddr;
+
+  if (hint != 0 && ROUND_UP(hint, PGSIZE) < t->stack_max)
+    t->stack_max = ROUND_UP(hint, PGSIZE);
+  if (page_cnt > t->stack_max / PGSIZE)
+    page_cnt = t->stack_max / PGSIZE;
+  if (page_cnt == 0)
+    page_cnt = 1;
+
+  if (page_add_vma(PHYS_BASE - page_cnt * PGSIZE, page_cnt, true) == NULL
+      || !page_load(top, true))
+    return false;
+  for (vaddr = top; vaddr > PHYS_BASE - page_cnt * PGSIZE;)
+  {
+    vaddr -= PGSIZE;
+    page_prefault(page_get(vaddr), true);
+  }
+  return true;
+}
+
+/* Handles a fault at addr with the stack pointer at esp if it hits
+   below the stack: extends the stack, the region of the current
+   process that ends at PHYS_BASE, down to addr, and to esp if that is
+   lower, and loads the page holding addr.  A stack that grows keeps
+   growing, so up to STACK_GROW_PAGES - 1 pages below are loaded too
+   while frames are free, saving a fault for each of them.  Returns
+   false if addr is not a stack access, lies beyond the stack limit,
+   or another region is in the way. */
+bool page_grow_stack(void *addr, void *esp)
+{
+  struct thread *t = thread_current();
+  void *upage = pg_round_down(addr);
+  void *limit = page_stack_limit();
+  void *lo, *vaddr;
+  struct vma *stack;
+  unsigned i;
+
+  /* PUSHA checks 32 bytes below the stack pointer */
+  if (addr < esp - 32 || upage < limit)
+    return false;
+  if (t->vma_cnt == 0 || page_vma_index(upage) != t->vma_cnt - 1)
+    return false;
+  stack = &t->vmas[t->vma_cnt - 1];
+  if (stack->end != PHYS_BASE)
+    return false;
+
+  /* Stay clear of the region below */
+  if (t->vma_cnt > 1 && limit < t->vmas[t->vma_cnt - 2].end)
+    limit = t->vmas[t->vma_cnt - 2].end;
+  lo = (size_t)(upage - limit) / PGSIZE >= STACK_GROW_PAGES - 1
+       ? upage - (STACK_GROW_PAGES - 1) * PGSIZE : limit;
+  if (esp < addr && pg_round_down(esp) < lo)
+    lo = pg_round_down(esp) > limit ? pg_round_down(esp) : limit;
+  if (lo < stack->start)
+    stack->start = lo;
+
+  if (!page_load(upage, true))
+    return false;
+  for (i = 1, vaddr = upage - PGSIZE; i < STACK_GROW_PAGES && vaddr >= lo;
+       i++, vaddr -= PGSIZE)
+    if (!page_prefault(page_get(vaddr), true))
+      break;
+  return true;
 }
 
 /* Returns the page containing the given virtual address,
@@ -48,45 +300,81 @@ page_lookup(void *address)
   return e != NULL ? hash_entry(e, struct page, hash_elem) : NULL;
 }
 
-/* Initializes the supplemental page table. */
-struct page *page_init(void *vaddr, bool writable)
+/* Creates the supplemental page table entry for the page at vaddr
+   of region v. */
+static struct page *page_init(struct vma *v, void *vaddr)
 {
   struct page *p = malloc(sizeof *p);
+  off_t ofs;
+
   if (p == NULL)
     PANIC("out of memory during page initialization");
 
   p->vaddr = pg_round_down(vaddr);
-  p->writable = writable;
+  ofs = p->vaddr - v->start;
+  p->writable = v->writable;
   p->thread = thread_current();
-  p->pinned = false;
+  p->pin_cnt = 0;
   p->swapped = false;
   p->swap_id = BLOCK_SECTOR_NULL;
   p->frame = NULL;
   p->file = NULL;
-  p->ofs = 0;
+  p->shm = v->shm;
+  p->ofs = v->ofs + ofs;
   p->read_bytes = 0;
-  p->type = VM_ANON;
+  if (v->file != NULL && ofs < v->file_bytes)
+  {
+    p->file = v->file;
+    p->read_bytes = v->file_bytes - ofs < PGSIZE ? v->file_bytes - ofs : PGSIZE;
+  }
+  p->type = v->type;
+  p->zero_mapped = false;
+  p->prefaulted = false;
   lock_init(&p->lock);
   hash_insert(thread_current()->supl_pt, &p->hash_elem);
   return p;
 }
 
+/* Returns the page containing addr, creating its entry from the
+   region holding addr the first time it is needed.  Returns a null
+   pointer if no region holds addr, or if large pages map it. */
+static struct page *page_get(void *addr)
+{
+  struct page *p = page_lookup(pg_round_down(addr));
+  struct vma *v;
+
+  if (p != NULL)
+    return p;
+  v = page_vma_lookup(addr);
+  return v != NULL && !v->huge ? page_init(v, addr) : NULL;
+}
+
+/* Reads the file contents of page p into the frame at kaddr and zeroes
+   the rest.  Returns false if the file is too short. */
+bool page_read_file(struct page *p, void *kaddr)
+{
+  size_t read_bytes = file_read_at(p->file, kaddr, p->read_bytes, p->ofs);
+  if (read_bytes != p->read_bytes)
+    return false;
+  size_t zero_bytes = PGSIZE - read_bytes;
+  memset(kaddr + p->read_bytes, 0, zero_bytes);
+  return true;
+}
+
 /* Loads a file into a page */
 void page_load_file(struct page *p)
 {
-  struct thread *cur = thread_current();
-  frame_io_wait();
-  size_t read_bytes = file_read_at(p->file, p->frame->kaddr, p->read_bytes, p->ofs);
-  frame_io_done();
-  if (read_bytes != p->read_bytes)
+  if (!page_read_file(p, p->frame->kaddr))
   {
     frame_free_frame(p->frame);
     p->frame = NULL;
-    printf("read_bytes: %d, p->read_bytes: %d\n", read_bytes, p->read_bytes);
-    return;
   }
-  size_t zero_bytes = PGSIZE - read_bytes;
-  memset(p->frame->kaddr + p->read_bytes, 0, zero_bytes);
+}
+
+/* Writes a memory-mapped file page back to its file */
+void page_write_file(struct page *p)
+{
+  file_write_at(p->file, p->frame->kaddr, p->read_bytes, p->ofs);
 }
 
 /* Loads a zero page */
@@ -95,82 +383,519 @@ void page_load_zero(struct page *p)
   memset(p->frame->kaddr, 0, PGSIZE);
 }
 
-/* Loads a page into memory. */
-bool page_load(void *addr)
+/* Loads page p, whose lock the caller holds, for writing if write is
+   true.  An anonymous page that is only read maps the zero page
+   instead of a frame of its own, and gets one on its first write.
+   If prefault is true, only a free frame is used, never an evicted
+   one. */
+static bool page_load_locked(struct page *p, bool write, bool prefault)
 {
-  struct thread *cur = thread_current();
-  void *rounded_addr = pg_round_down(addr);
-  struct page *p = page_lookup(rounded_addr);
-  if (p == NULL)
-    return false;
+  uint32_t *pd = p->thread->pagedir;
+
+  /* A page reading as zeros gets its own frame on the first write */
+  if (p->zero_mapped)
+  {
+    if (!write)
+      return true;
+    pagedir_clear_page(pd, p->vaddr);
+    p->zero_mapped = false;
+  }
+
+  /* Shared memory pages find their frame through the segment */
+  if (p->type == VM_SHM)
+    return shm_load(p);
+
+  /* Read-only executable pages find theirs through the code table */
+  if (code_is_shared(p))
+  {
+    bool success = code_load(p, prefault);
+    p->type = VM_BIN;
+    return success;
+  }
+
+  /* An untouched anonymous page reads as zeros, so share the zero page */
+  if (!write && p->file == NULL && !p->swapped && p->frame == NULL)
+  {
+    bool success = pagedir_set_page(pd, p->vaddr, zero_page, false);
+    if (success)
+    {
+      p->zero_mapped = true;
+      p->type = VM_ANON;
+      vmstat_count(VMSTAT_ZERO_FAULT);
+    }
+    return success;
+  }
 
-  lock_acquire(&p->lock);
   /* Acquire a frame */
-  p->frame = frame_get_frame(PAL_USER);
-  if (p->frame == NULL)
+  struct frame *frame = prefault ? frame_try_get_frame(PAL_USER)
+                                 : frame_get_frame(PAL_USER);
+  if (frame == NULL)
     return false;
-  p->frame->page = p;
+  frame_attach(frame, p);
 
-  bool success = pagedir_set_page(cur->pagedir, p->vaddr,
-                                  p->frame->kaddr, p->writable);
+  bool success = pagedir_set_page(pd, p->vaddr, p->frame->kaddr, p->writable);
   if (!success)
   {
     frame_free_frame(p->frame);
     return false;
   }
-  pagedir_set_accessed(p->thread->pagedir, p->vaddr, true);
+  pagedir_set_accessed(pd, p->vaddr, true);
 
   /* Load the data into the page */
   if (p->swapped)
   {
-    frame_io_wait();
     swap_in(p->frame->kaddr, p->swap_id);
-    frame_io_done();
     p->swapped = false;
     p->swap_id = BLOCK_SECTOR_NULL;
+    vmstat_count(VMSTAT_SWAP_FAULT);
   }
   else if (p->file != NULL)
   {
     page_load_file(p);
-    p->type = VM_BIN;
+    if (p->type != VM_FILE)
+      p->type = VM_BIN;
+    vmstat_count(VMSTAT_FILE_FAULT);
   }
   else
   {
     page_load_zero(p);
     p->type = VM_ANON;
+    vmstat_count(VMSTAT_ZERO_FAULT);
   }
 
+  return true;
+}
+
+/* Loads a page into memory, for writing if write is true. */
+bool page_load(void *addr, bool write)
+{
+  struct page *p = page_get(addr);
+  if (p == NULL)
+    return false;
+
+  lock_acquire(&p->lock);
+  bool success = page_load_locked(p, write, false);
   lock_release(&p->lock);
 
-  return true;
+  return success;
+}
+
+/* Returns true if page q lies in the same file-backed segment as
+   page p, so that faulting on p predicts q being needed. */
+static bool page_same_segment(struct page *p, struct page *q)
+{
+  return q != NULL && q->file == p->file && q->writable == p->writable
+         && (q->type == VM_FILE) == (p->type == VM_FILE);
+}
+
+/* Prefaults page q of the current process, for writing if write is
+   true, if it is not resident and a frame is free.  Returns true if q
+   was loaded. */
+static bool page_prefault(struct page *q, bool write)
+{
+  bool success = false;
+
+  if (!lock_try_acquire(&q->lock))
+    return false;
+  if (q->frame == NULL && !q->swapped)
+  {
+    success = page_load_locked(q, write, true);
+    if (success)
+    {
+      /* Unused prefaulted pages are the first to go */
+      pagedir_set_accessed(q->thread->pagedir, q->vaddr, false);
+      q->prefaulted = true;
+    }
+  }
+  lock_release(&q->lock);
+  return success;
+}
+
+/* Prefaults the page at addr, which lies in the same file-backed
+   segment as page p, if it is not resident.  Creates the page's
+   entry if it has none, and deletes the entry again if the prefault
+   fails, so that none is left that is neither resident nor swapped.
+   Returns false if the page is outside the segment or could not be
+   loaded. */
+static bool page_prefault_near(struct page *p, void *addr)
+{
+  struct page *q = page_lookup(addr);
+  bool fresh = q == NULL;
+
+  if (fresh)
+    q = page_get(addr);
+  if (page_same_segment(p, q) && (q->frame != NULL || page_prefault(q, false)))
+    return true;
+  if (fresh && q != NULL)
+  {
+    hash_delete(thread_current()->supl_pt, &q->hash_elem);
+    page_destroy(&q->hash_elem, NULL);
+  }
+  return false;
+}
+
+/* Adjusts how far the current process faults around, by how many of
+   the pages prefaulted last time have been touched since. */
+static void page_fault_around_adapt(struct thread *cur)
+{
+  unsigned loaded = 0, used = 0;
+  void *vaddr;
+
+  for (vaddr = cur->fault_around_lo; vaddr < cur->fault_around_hi; vaddr += PGSIZE)
+  {
+    struct page *q = page_lookup(vaddr);
+    if (q == NULL || !q->prefaulted)
+      continue;
+    q->prefaulted = false;
+    loaded++;
+    if (pagedir_is_accessed(cur->pagedir, vaddr))
+      used++;
+  }
+
+  if (loaded == 0)
+    return;
+  if (used * 2 >= loaded && cur->fault_around < FAULT_AROUND_MAX)
+    cur->fault_around *= 2;
+  else if (used * 4 < loaded && cur->fault_around > 1)
+    cur->fault_around /= 2;
+}
+
+/* Makes the resident pages just below page p of region v, which the
+   process sweeps in ascending order, the first to be evicted: it is
+   done with them. */
+static void page_deactivate_behind(struct page *p, struct vma *v)
+{
+  void *vaddr;
+  unsigned i;
+
+  for (i = 0, vaddr = p->vaddr; i <= FAULT_AROUND_MAX && vaddr > v->start; i++)
+  {
+    struct page *q = page_lookup(vaddr -= PGSIZE);
+    if (q == NULL || !lock_try_acquire(&q->lock))
+      break;
+    if (q->frame == NULL)
+    {
+      lock_release(&q->lock);
+      break;
+    }
+    frame_deactivate(q->frame);
+    lock_release(&q->lock);
+  }
+}
+
+/* Following a fault on the page at addr, loads up to the process's
+   fault-around count of non-resident pages of the same file-backed
+   segment on each side of it, as long as frames are free.  A region
+   advised MADV_SEQUENTIAL is read ahead only, as far as
+   FAULT_AROUND_MAX, and gives up the pages behind; one advised
+   MADV_RANDOM is not faulted around. */
+void page_fault_around(void *addr)
+{
+  struct thread *cur = thread_current();
+  struct page *p = page_lookup(pg_round_down(addr));
+  struct vma *v = page_vma_lookup(addr);
+  void *lo, *hi, *file_end;
+  unsigned i, ahead, behind;
+
+  if (p == NULL || v == NULL || v->advice == MADV_RANDOM)
+    return;
+  if (v->advice == MADV_SEQUENTIAL)
+    page_deactivate_behind(p, v);
+  if (p->file == NULL || p->type == VM_SHM)
+    return;
+
+  page_fault_around_adapt(cur);
+  ahead = v->advice == MADV_SEQUENTIAL ? FAULT_AROUND_MAX : cur->fault_around;
+  behind = v->advice == MADV_SEQUENTIAL ? 0 : cur->fault_around;
+
+  /* Stay within the part of the region that the file backs */
+  file_end = v->start + ROUND_UP(v->file_bytes, PGSIZE);
+  lo = hi = p->vaddr;
+  for (i = 0; i < ahead && hi + PGSIZE < file_end; i++)
+  {
+    if (!page_prefault_near(p, hi + PGSIZE))
+      break;
+    hi += PGSIZE;
+  }
+  for (i = 0; i < behind && lo > v->start; i++)
+  {
+    if (!page_prefault_near(p, lo - PGSIZE))
+      break;
+    lo -= PGSIZE;
+  }
+
+  cur->fault_around_lo = lo;
+  cur->fault_around_hi = hi + PGSIZE;
+}
+
+/* Loads the pages of the current process from start up to end whose
+   contents are in a file or in swap, as long as frames are free.
+   Entries created for pages that are not loaded are deleted again. */
+static void page_willneed(void *start, void *end)
+{
+  struct thread *cur = thread_current();
+  void *vaddr;
+
+  for (vaddr = start; vaddr < end; vaddr += PGSIZE)
+  {
+    struct page *q = page_lookup(vaddr);
+    bool fresh = q == NULL;
+    bool tried = false, loaded = false;
+
+    if (fresh)
+      q = page_get(vaddr);
+    if (q == NULL)
+      continue;
+    if (q->type != VM_SHM && (q->file != NULL || q->swapped)
+        && lock_try_acquire(&q->lock))
+    {
+      tried = true;
+      loaded = q->frame != NULL || page_load_locked(q, false, true);
+      lock_release(&q->lock);
+    }
+    if (fresh && !loaded)
+    {
+      hash_delete(cur->supl_pt, &q->hash_elem);
+      page_destroy(&q->hash_elem, NULL);
+    }
+    /* Stop once no frame is free */
+    if (tried && !loaded)
+      break;
+  }
+}
+
+/* Puts the pages of the current process from start up to end on
+   list pages, in no particular order.  Looks each address up when the
+   range is small next to the supplemental page table, and walks the
+   table otherwise, so a large range with few loaded pages costs only
+   what those pages do. */
+static void page_range_list(void *start, void *end, struct list *pages)
+{
+  struct hash *supl_pt = thread_current()->supl_pt;
+  struct hash_iterator i;
+  void *vaddr;
+
+  list_init(pages);
+  if ((size_t)(end - start) / PGSIZE <= hash_size(supl_pt))
+  {
+    for (vaddr = start; vaddr < end; vaddr += PGSIZE)
+    {
+      struct page *p = page_lookup(vaddr);
+      if (p != NULL)
+        list_push_back(pages, &p->range_elem);
+    }
+    return;
+  }
+  hash_first(&i, supl_pt);
+  while (hash_next(&i))
+  {
+    struct page *p = hash_entry(hash_cur(&i), struct page, hash_elem);
+    if (p->vaddr >= start && p->vaddr < end)
+      list_push_back(pages, &p->range_elem);
+  }
+}
+
+/* Returns true if page p is pinned for I/O in progress.  Pins that
+   eviction takes last only while it holds the page's lock. */
+static bool page_is_pinned(struct page *p)
+{
+  bool pinned;
+
+  lock_acquire(&p->lock);
+  pinned = p->pin_cnt > 0;
+  lock_release(&p->lock);
+  return pinned;
+}
+
+/* Drops the pages of the current process from start up to end.  The
+   next access finds them as they were when the region was created:
+   read from the file, zeroed, or as the segment holds them.  Changes
+   to a mapped file are written back first.  Pages in large pages
+   stay, and are zeroed.  Pages pinned for I/O still in progress,
+   such as an outstanding aio_read(), are left as they are. */
+static void page_dontneed(void *start, void *end)
+{
+  struct thread *cur = thread_current();
+  struct list pages;
+  void *vaddr;
+
+  /* Large pages have no entries in the page table */
+  for (vaddr = start; vaddr < end; vaddr = page_vma_lookup(vaddr)->end)
+  {
+    struct vma *v = page_vma_lookup(vaddr);
+    if (v->huge)
+      memset(vaddr, 0, (v->end < end ? v->end : end) - vaddr);
+  }
+
+  page_range_list(start, end, &pages);
+  while (!list_empty(&pages))
+  {
+    struct page *p = list_entry(list_pop_front(&pages), struct page, range_elem);
+    if (!page_is_pinned(p))
+    {
+      hash_delete(cur->supl_pt, &p->hash_elem);
+      page_destroy(&p->hash_elem, NULL);
+    }
+  }
+}
+
+/* Takes advice on how the current process will use the size bytes
+   from page-aligned addr.  MADV_NORMAL, MADV_RANDOM and
+   MADV_SEQUENTIAL apply to every region the range touches, in
+   full.  Returns false if addr is not page-aligned or part of the
+   range is not mapped. */
+bool page_advise(void *addr, size_t size, enum madvise_advice advice)
+{
+  void *end = pg_round_up(addr + size);
+  void *vaddr;
+
+  if (pg_ofs(addr) != 0 || !is_user_vaddr(addr) || end < addr || end > PHYS_BASE)
+    return false;
+  for (vaddr = addr; vaddr < end; vaddr = page_vma_lookup(vaddr)->end)
+    if (page_vma_lookup(vaddr) == NULL)
+      return false;
+
+  switch (advice)
+  {
+  case MADV_NORMAL:
+  case MADV_RANDOM:
+  case MADV_SEQUENTIAL:
+    for (vaddr = addr; vaddr < end; vaddr = page_vma_lookup(vaddr)->end)
+      page_vma_lookup(vaddr)->advice = advice;
+    return true;
+
+  case MADV_WILLNEED:
+    page_willneed(addr, end);
+    return true;
+
+  case MADV_DONTNEED:
+    page_dontneed(addr, end);
+    return true;
+
+  default:
+    return false;
+  }
 }
 
 /* Frees a page and set their corresponding frame as free */
 void page_destroy(struct hash_elem *e, void *aux UNUSED)
 {
   struct page *p = hash_entry(e, struct page, hash_elem);
+  uint32_t *pd = thread_current()->pagedir;
   lock_acquire(&p->lock);
+  bool dirty = pagedir_is_dirty(pd, p->vaddr);
+  pagedir_clear_page(pd, p->vaddr);
   if (p->frame != NULL)
   {
-    frame_free_frame(p->frame);
+    /* Changes to a mapped file go back to the file */
+    if (p->type == VM_FILE && dirty)
+      page_write_file(p);
+
+    /* A segment keeps its frames after the last mapping goes away */
+    struct frame *frame = p->frame;
+    if (code_is_shared(p))
+      code_unmap(p);
+    else if (frame_detach(frame, p) == 0 && p->type != VM_SHM)
+      frame_free_frame(frame);
   }
-  pagedir_clear_page(thread_current()->pagedir, p->vaddr);
+  else if (p->swapped)
+    swap_free(p->swap_id);
   free(p);
 }
 
+/* Removes the region of the current process that starts at start,
+   freeing the pages of it that were loaded.  Returns false, and
+   leaves the region as it is, if I/O in progress such as an
+   outstanding aio request still has any of its pages pinned. */
+bool page_remove_vma(void *start)
+{
+  struct thread *cur = thread_current();
+  struct vma *v = page_vma_lookup(start);
+  struct list pages;
+  struct list_elem *e;
+  size_t i;
+
+  if (v == NULL || v->start != start)
+    return false;
+  page_range_list(v->start, v->end, &pages);
+  for (e = list_begin(&pages); e != list_end(&pages); e = list_next(e))
+    if (page_is_pinned(list_entry(e, struct page, range_elem)))
+      return false;
+  if (v->huge)
+    page_release_huge(v);
+  while (!list_empty(&pages))
+  {
+    struct page *p = list_entry(list_pop_front(&pages), struct page, range_elem);
+    hash_delete(cur->supl_pt, &p->hash_elem);
+    page_destroy(&p->hash_elem, NULL);
+  }
+  i = v - cur->vmas;
+  memmove(v, v + 1, (cur->vma_cnt - i - 1) * sizeof *v);
+  cur->vma_cnt--;
+  return true;
+}
+
+/* Counts the pages of the current process held in frames into
+   resident, and those held in swap into swapped. */
+void page_count(size_t *resident, size_t *swapped)
+{
+  struct thread *cur = thread_current();
+  struct hash_iterator i;
+  size_t j;
+
+  *resident = *swapped = 0;
+  for (j = 0; j < cur->vma_cnt; j++)
+    if (cur->vmas[j].huge)
+      *resident += (cur->vmas[j].end - cur->vmas[j].start) / PGSIZE;
+  if (cur->supl_pt == NULL)
+    return;
+  hash_first(&i, cur->supl_pt);
+  while (hash_next(&i))
+  {
+    struct page *p = hash_entry(hash_cur(&i), struct page, hash_elem);
+    if (p->frame != NULL)
+      (*resident)++;
+    else if (p->swapped)
+      (*swapped)++;
+  }
+}
+
 /* Destroys the supplemental page table. */
 void page_exit(void)
 {
   struct thread *cur = thread_current();
+  size_t i;
+
+  for (i = 0; i < cur->vma_cnt; i++)
+    if (cur->vmas[i].huge)
+      page_release_huge(&cur->vmas[i]);
   if (cur->supl_pt != NULL)
   {
     hash_destroy(cur->supl_pt, page_destroy);
     free(cur->supl_pt);
+    cur->supl_pt = NULL;
   }
+  free(cur->vmas);
+  cur->vmas = NULL;
+  cur->vma_cnt = cur->vma_cap = 0;
 }
 
-/* Initializes pages of buffer that have not yet been initialized */
-void page_load_buffer_pages(void *buffer, size_t size, bool writable)
+/* Drops one pin from page p. */
+static void page_unpin(struct page *p)
+{
+  lock_acquire(&p->lock);
+  if (p->pin_cnt > 0)
+    p->pin_cnt--;
+  lock_release(&p->lock);
+}
+
+/* Loads the pages of buffer that are not present, for writing if
+   writable is true, and pins them.  Each page is loaded and pinned
+   under its lock in one step, so that eviction cannot take it in
+   between.  Exits the process if the buffer is not all mapped, or if
+   it should be written but is not writable.  Pins nest, so a page
+   stays pinned until page_unpin_pages() has dropped every pin. */
+void page_pin_pages(void *buffer, size_t size, bool writable)
 {
   if (buffer == NULL)
   {
@@ -178,45 +903,116 @@ void page_load_buffer_pages(void *buffer, size_t size, bool writable)
   }
   void *start_page = pg_round_down(buffer);
   void *end_page = pg_round_up(buffer + size);
-  /* Exits if the page has not a legitimate pointer address
-     or if the start of the pointer has not been initialized */
-  if (start_page < VADDR_START || end_page > PHYS_BASE || !page_lookup(start_page))
+  if (start_page < VADDR_START || end_page > PHYS_BASE || !page_vma_lookup(start_page))
   {
     exit(-1);
   }
 
+  /* Check the whole buffer first, so that exiting leaves no pins */
+  struct list pages;
+  struct list_elem *e;
   struct page *p;
+  list_init(&pages);
   for (void *vaddr = start_page; vaddr < end_page; vaddr += PGSIZE)
   {
-    p = page_lookup(vaddr);
+    /* Large pages are writable and always loaded */
+    struct vma *v = page_vma_lookup(vaddr);
+    if (v != NULL && v->huge)
+    {
+      continue;
+    }
+    p = page_get(vaddr);
+    /* Exits if the buffer runs into a hole between regions */
     if (!p)
     {
-      p = page_init(vaddr, true);
+      exit(-1);
     }
     /* Exits if the page is not writable but should be */
-    if (writable && !p->writable) 
+    if (writable && !p->writable)
     {
       exit(-1);
     }
-    if (!pagedir_get_page(thread_current()->pagedir, vaddr))
+    list_push_back(&pages, &p->range_elem);
+  }
+
+  for (e = list_begin(&pages); e != list_end(&pages); e = list_next(e))
+  {
+    bool loaded = true;
+    p = list_entry(e, struct page, range_elem);
+    lock_acquire(&p->lock);
+    /* The kernel must not write through to the zero page */
+    if (p->frame == NULL)
+      loaded = page_load_locked(p, writable, false);
+    if (loaded)
+      p->pin_cnt++;
+    lock_release(&p->lock);
+    if (!loaded)
     {
-      page_load(vaddr);
+      /* Drop the pins already taken */
+      while (e != list_begin(&pages))
+      {
+        e = list_prev(e);
+        page_unpin(list_entry(e, struct page, range_elem));
+      }
+      exit(-1);
     }
   }
 }
 
-/* Pins/unpins pages of buffer */
-void page_pin_pages(void *buffer, size_t size, bool enable)
+/* Drops one pin, taken by page_pin_pages(), from each page of
+   buffer. */
+void page_unpin_pages(void *buffer, size_t size)
 {
-  if (buffer == NULL)
+  struct list pages;
+
+  /* Pages in large pages are never evicted anyway */
+  page_range_list(pg_round_down(buffer), pg_round_up(buffer + size), &pages);
+  while (!list_empty(&pages))
+    page_unpin(list_entry(list_pop_front(&pages), struct page, range_elem));
+}
+
+/* Replaces the contents of the user page at UPAGE with FRAME, which
+   must belong to no page.  Lets a pipe hand a whole page to the reader
+   instead of copying it.  Returns false if UPAGE is not a writable
+   page of the current process. */
+bool page_install_frame(void *upage, struct frame *frame)
+{
+  struct thread *cur = thread_current();
+  struct page *p = page_lookup(upage);
+  if (p == NULL || !p->writable || p->type == VM_SHM || p->type == VM_FILE)
+    return false;
+
+  ASSERT(frame->ref_cnt == 0);
+  lock_acquire(&p->lock);
+  if (p->frame != NULL)
   {
-    exit(-1);
+    pagedir_clear_page(cur->pagedir, p->vaddr);
+    frame_free_frame(p->frame);
+  }
+  else if (p->zero_mapped)
+  {
+    pagedir_clear_page(cur->pagedir, p->vaddr);
+    p->zero_mapped = false;
+  }
+  else if (p->swapped)
+  {
+    swap_free(p->swap_id);
+    p->swapped = false;
+    p->swap_id = BLOCK_SECTOR_NULL;
   }
-  void *start_page = pg_round_down(buffer);
-  void *end_page = pg_round_up(buffer + size);
 
-  for (void *vaddr = start_page; vaddr < end_page; vaddr += PGSIZE)
+  if (!pagedir_set_page(cur->pagedir, p->vaddr, frame->kaddr, true))
   {
-    page_lookup(vaddr)->pinned = enable;
+    lock_release(&p->lock);
+    return false;
   }
+
+  /* The old contents are gone, so never reload them from the file. */
+  p->file = NULL;
+  p->type = VM_ANON;
+  frame_attach(frame, p);
+  pagedir_set_dirty(cur->pagedir, p->vaddr, true);
+  pagedir_set_accessed(cur->pagedir, p->vaddr, true);
+  lock_release(&p->lock);
+  return true;
 }
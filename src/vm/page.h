@@ -2,6 +2,7 @@
 #define VM_PAGE_H
 #include <hash.h>
 #include <list.h>
+#include <madvise.h>
 #include "devices/block.h"
 #include <debug.h>
 #include "filesys/off_t.h"
@@ -11,37 +12,92 @@
 enum page_type
 {
   VM_BIN, /* For ELF files */
-  VM_ANON /* For stack pages and zero initialized pages */
+  VM_ANON, /* For stack pages and zero initialized pages */
+  VM_SHM,  /* For shared memory segments */
+  VM_FILE  /* For memory-mapped files */
+};
+
+/* Initial and largest number of pages faulted around a file-backed
+   page on each side. */
+#define FAULT_AROUND_INIT 4
+#define FAULT_AROUND_MAX 16
+
+/* Pages of stack mapped by one stack fault, and by exec at most. */
+#define STACK_GROW_PAGES 8
+
+/* Bytes mapped by one large page: what a whole page table maps. */
+#define HUGE_PAGE_SIZE (4 * 1024 * 1024)
+
+/* Regions a process starts with room for: code, data and stack. */
+#define VMA_INIT_CNT 4
+
+/* A region of a process's address space: the pages from start up to
+   end, whose contents all come from the same place.  A process keeps
+   its regions sorted by address, and has a struct page only for the
+   pages of a region that have been loaded. */
+struct vma
+{
+  void *start;         /* First page. */
+  void *end;           /* Page after the last one. */
+  enum page_type type; /* Type of every page. */
+  bool writable;       /* True if writable, false if read-only. */
+  struct file *file;   /* File backing the region, or NULL. */
+  struct shm *shm;     /* Segment backing the region, or NULL. */
+  off_t ofs;           /* Offset of start in file or segment. */
+  off_t file_bytes;    /* Bytes of file from ofs; the rest reads as zeros. */
+  enum madvise_advice advice; /* How the process says it uses the region. */
+  bool huge;           /* True if mapped with large pages. */
 };
 
 struct page
 {                             /* Supplemental page table entry */
   void *vaddr;                /* Virtual address of the page */
   struct frame *frame;        /* Frame that is used by the page */
+  struct list_elem frame_elem; /* For the frame's list of pages. */
   struct hash_elem hash_elem; /* For supplemental page hash table. */
+  struct list_elem range_elem; /* For a list of the pages in a range. */
   struct thread *thread;      /* Owner process. */
   /* File stuff */
   struct file *file; /* File to be mapped. */
-  off_t ofs;         /* Offset in file. */
+  struct shm *shm;   /* Segment to be mapped. */
+  off_t ofs;         /* Offset in file or segment. */
   size_t read_bytes; /* Bytes to read from file. */
   /* Additional page information */
   bool writable;          /* True if writable, false if read-only. */
-  bool pinned;            /* True if pinned, false otherwise. */
+  unsigned pin_cnt;       /* Number of outstanding pins, 0 if evictable. */
   bool swapped;           /* True if swapped out, false otherwise. */
   block_sector_t swap_id; /* Swap ID of swapped data */
   enum page_type type;    /* Type of a page. */
+  bool zero_mapped;       /* True if mapped read-only to the zero page. */
+  bool prefaulted;        /* True if loaded ahead of a fault, not yet checked. */
   struct lock lock;       /* Lock for page to prevent simulatneous acccess to the page */
 };
 
 unsigned page_hash(const struct hash_elem *p_, void *aux UNUSED);
 bool page_less(const struct hash_elem *a_, const struct hash_elem *b_, void *aux UNUSED);
 
+void page_zero_init(void);
+void page_stack_init(size_t max);
+void page_huge_init(bool enable);
+bool page_huge_enabled(void);
 bool page_init_table(void);
-struct page *page_init(void *vaddr, bool writable);
+struct vma *page_add_vma(void *start, size_t page_cnt, bool writable);
+struct vma *page_vma_lookup(const void *addr);
+bool page_add_huge(void *start, size_t page_cnt);
+bool page_remove_vma(void *start);
+void *page_stack_limit(void);
+bool page_add_stack(size_t hint, size_t page_cnt);
+bool page_grow_stack(void *addr, void *esp);
 struct page *page_lookup(void *address);
 void page_exit(void);
-bool page_load(void *addr);
-void page_load_buffer_pages(void *buffer, size_t size, bool writable);
-void page_pin_pages(void *buffer, size_t size, bool enable);
+void page_count(size_t *resident, size_t *swapped);
+bool page_load(void *addr, bool write);
+void page_fault_around(void *addr);
+bool page_advise(void *addr, size_t size, enum madvise_advice advice);
+bool page_read_file(struct page *p, void *kaddr);
+void page_write_file(struct page *p);
+void page_pin_pages(void *buffer, size_t size, bool writable);
+void page_unpin_pages(void *buffer, size_t size);
+bool page_install_frame(void *upage, struct frame *frame);
 
 #endif /* vm/page.h */
\ No newline at end of file
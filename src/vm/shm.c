@@ -0,0 +1,356 @@
+#include "vm/shm.h"
+#include <debug.h>
+#include <list.h>
+#include <round.h>
+#include <string.h>
+#include "devices/block.h"
+#include "threads/malloc.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+#include "userprog/pagedir.h"
+#include "vm/frame.h"
+#include "vm/page.h"
+#include "vm/swap.h"
+#include "vm/vmstat.h"
+
+/* One page of a segment. */
+struct shm_slot
+{
+  struct frame *frame;    /* Resident frame, or NULL. */
+  block_sector_t swap_id; /* Swap slot while swapped out, else BLOCK_SECTOR_NULL. */
+};
+
+/* A named shared memory segment.
+   Its pages live in frames mapped by every process that maps the
+   segment.  The segment, not any one process, owns those frames and
+   their swap slots, so it outlives mappings until the last process
+   that opened or mapped it lets go. */
+struct shm
+{
+  int id;                       /* Segment identifier. */
+  char name[SHM_NAME_MAX + 1];  /* Name given to shm_open(). */
+  size_t page_cnt;              /* Number of pages. */
+  struct shm_slot *slots;       /* Where each page is. */
+  unsigned ref_cnt;             /* Opens and mappings. */
+  struct lock lock;             /* Guards SLOTS. */
+  struct list_elem elem;        /* For shm_list. */
+};
+
+/* A process's hold on a segment: it opened the segment, or mapped
+   it at ADDR. */
+struct shm_ref
+{
+  struct shm *shm;              /* Segment. */
+  void *addr;                   /* Mapping address, or NULL if only opened. */
+  struct list_elem elem;        /* For the thread's shm_refs. */
+};
+
+/* All segments. */
+static struct list shm_list;
+static struct lock shm_list_lock;
+static int shm_next_id;
+
+/* Initializes the list of segments. */
+void shm_init(void)
+{
+  list_init(&shm_list);
+  lock_init(&shm_list_lock);
+}
+
+/* Returns the segment named NAME, or NULL.  Caller holds shm_list_lock. */
+static struct shm *
+shm_find(const char *name)
+{
+  struct list_elem *e;
+  for (e = list_begin(&shm_list); e != list_end(&shm_list); e = list_next(e))
+  {
+    struct shm *shm = list_entry(e, struct shm, elem);
+    if (!strcmp(shm->name, name))
+      return shm;
+  }
+  return NULL;
+}
+
+/* Returns the current process's reference to segment SHMID mapped at
+   ADDR, or only opened if ADDR is NULL.  A negative SHMID matches any
+   segment. */
+static struct shm_ref *
+shm_find_ref(int shmid, void *addr)
+{
+  struct list *refs = &thread_current()->shm_refs;
+  struct list_elem *e;
+  for (e = list_begin(refs); e != list_end(refs); e = list_next(e))
+  {
+    struct shm_ref *ref = list_entry(e, struct shm_ref, elem);
+    if ((shmid < 0 || ref->shm->id == shmid) && ref->addr == addr)
+      return ref;
+  }
+  return NULL;
+}
+
+/* Adds a reference to SHM at ADDR to the current process.
+   Returns false if memory runs out. */
+static bool
+shm_add_ref(struct shm *shm, void *addr)
+{
+  struct shm_ref *ref = malloc(sizeof *ref);
+  if (ref == NULL)
+    return false;
+  ref->shm = shm;
+  ref->addr = addr;
+  list_push_back(&thread_current()->shm_refs, &ref->elem);
+
+  lock_acquire(&shm_list_lock);
+  shm->ref_cnt++;
+  lock_release(&shm_list_lock);
+  return true;
+}
+
+/* Drops a reference to SHM, freeing it with its frames and swap slots
+   when no process holds it any more. */
+static void
+shm_release(struct shm *shm)
+{
+  size_t i;
+
+  lock_acquire(&shm_list_lock);
+  if (--shm->ref_cnt > 0)
+  {
+    lock_release(&shm_list_lock);
+    return;
+  }
+  list_remove(&shm->elem);
+  lock_release(&shm_list_lock);
+
+  /* No page maps the segment any more, so nothing else can reach its
+     frames. */
+  for (i = 0; i < shm->page_cnt; i++)
+  {
+    if (shm->slots[i].frame != NULL)
+      frame_free_frame(shm->slots[i].frame);
+    else if (shm->slots[i].swap_id != BLOCK_SECTOR_NULL)
+      swap_free(shm->slots[i].swap_id);
+  }
+  free(shm->slots);
+  free(shm);
+}
+
+/* Opens the segment called NAME, creating it with room for SIZE bytes
+   if it does not exist.  Returns the segment's id, or -1 if NAME is
+   unusable, an existing segment is smaller than SIZE or memory runs
+   out. */
+int shm_open(const char *name, size_t size)
+{
+  struct shm *shm;
+  size_t i;
+
+  if (name[0] == '\0' || strlen(name) > SHM_NAME_MAX || size == 0
+      || DIV_ROUND_UP(size, PGSIZE) > SHM_MAX_PAGES)
+    return -1;
+
+  lock_acquire(&shm_list_lock);
+  shm = shm_find(name);
+  if (shm == NULL)
+  {
+    shm = malloc(sizeof *shm);
+    if (shm == NULL)
+      goto fail;
+    shm->page_cnt = DIV_ROUND_UP(size, PGSIZE);
+    shm->slots = malloc(shm->page_cnt * sizeof *shm->slots);
+    if (shm->slots == NULL)
+    {
+      free(shm);
+      goto fail;
+    }
+    for (i = 0; i < shm->page_cnt; i++)
+    {
+      shm->slots[i].frame = NULL;
+      shm->slots[i].swap_id = BLOCK_SECTOR_NULL;
+    }
+    shm->id = shm_next_id++;
+    strlcpy(shm->name, name, sizeof shm->name);
+    shm->ref_cnt = 0;
+    lock_init(&shm->lock);
+    list_push_back(&shm_list, &shm->elem);
+  }
+  else if (size > shm->page_cnt * PGSIZE)
+    goto fail;
+
+  /* Take the reference before dropping the list lock, so that the new
+     segment cannot be freed under us. */
+  if (shm_find_ref(shm->id, NULL) == NULL)
+  {
+    struct shm_ref *ref = malloc(sizeof *ref);
+    if (ref == NULL)
+    {
+      if (shm->ref_cnt == 0)
+      {
+        list_remove(&shm->elem);
+        free(shm->slots);
+        free(shm);
+      }
+      goto fail;
+    }
+    ref->shm = shm;
+    ref->addr = NULL;
+    list_push_back(&thread_current()->shm_refs, &ref->elem);
+    shm->ref_cnt++;
+  }
+  lock_release(&shm_list_lock);
+  return shm->id;
+
+fail:
+  lock_release(&shm_list_lock);
+  return -1;
+}
+
+/* Maps all of segment SHMID, which the current process must have
+   opened, at page-aligned ADDR.  Pages are loaded on first touch.
+   Returns ADDR, or NULL if the range is unusable or memory runs out. */
+void *shm_map(int shmid, void *addr)
+{
+  struct shm_ref *open_ref = shm_find_ref(shmid, NULL);
+  struct shm *shm;
+  struct vma *v;
+
+  if (open_ref == NULL || addr == NULL || pg_ofs(addr) != 0)
+    return NULL;
+  shm = open_ref->shm;
+
+  /* Stay clear of the code and the stack, and of anything mapped. */
+  if (addr < (void *)VADDR_START || addr >= page_stack_limit()
+      || (size_t)(page_stack_limit() - addr) / PGSIZE < shm->page_cnt)
+    return NULL;
+  v = page_add_vma(addr, shm->page_cnt, true);
+  if (v == NULL)
+    return NULL;
+  v->type = VM_SHM;
+  v->shm = shm;
+
+  if (!shm_add_ref(shm, addr))
+  {
+    page_remove_vma(addr);
+    return NULL;
+  }
+  return addr;
+}
+
+/* Removes the pages of mapping REF and drops it.  Returns false,
+   keeping REF, if I/O in progress still has some of its pages
+   pinned. */
+static bool
+shm_unmap_ref(struct shm_ref *ref)
+{
+  if (!page_remove_vma(ref->addr))
+    return false;
+  list_remove(&ref->elem);
+  shm_release(ref->shm);
+  free(ref);
+  return true;
+}
+
+/* Unmaps the segment mapped at ADDR.  Returns false if no segment is
+   mapped there, or if I/O in progress still uses it. */
+bool shm_unmap(void *addr)
+{
+  struct shm_ref *ref;
+
+  if (addr == NULL)
+    return false;
+  ref = shm_find_ref(-1, addr);
+  if (ref == NULL)
+    return false;
+  return shm_unmap_ref(ref);
+}
+
+/* Unmaps and closes every segment of the exiting process.
+   Must run before its supplemental page table goes away, and after
+   aio_exit(), which leaves no page pinned. */
+void shm_exit(void)
+{
+  struct list *refs = &thread_current()->shm_refs;
+
+  while (!list_empty(refs))
+  {
+    struct shm_ref *ref = list_entry(list_front(refs), struct shm_ref, elem);
+    if (ref->addr != NULL)
+    {
+      bool removed = shm_unmap_ref(ref);
+      ASSERT(removed);
+    }
+    else
+    {
+      list_remove(&ref->elem);
+      shm_release(ref->shm);
+      free(ref);
+    }
+  }
+}
+
+/* Maps shared memory page P, whose lock the caller holds, to the
+   segment's frame for it, bringing that frame in first if no other
+   mapper has.  Returns false if the mapping cannot be made. */
+bool shm_load(struct page *p)
+{
+  struct shm *shm = p->shm;
+  struct shm_slot *slot = &shm->slots[p->ofs / PGSIZE];
+  struct frame *spare = NULL;
+  bool success;
+
+  if (p->frame != NULL)
+    return true;
+
+  lock_acquire(&shm->lock);
+  while (slot->frame == NULL && spare == NULL)
+  {
+    /* Getting a frame may evict one of this segment's, so drop the
+       lock meanwhile. */
+    lock_release(&shm->lock);
+    spare = frame_get_frame(PAL_USER);
+    lock_acquire(&shm->lock);
+  }
+  if (slot->frame == NULL)
+  {
+    if (slot->swap_id != BLOCK_SECTOR_NULL)
+    {
+      swap_in(spare->kaddr, slot->swap_id);
+      slot->swap_id = BLOCK_SECTOR_NULL;
+      vmstat_count(VMSTAT_SWAP_FAULT);
+    }
+    else
+    {
+      memset(spare->kaddr, 0, PGSIZE);
+      vmstat_count(VMSTAT_ZERO_FAULT);
+    }
+    slot->frame = spare;
+    slot->frame->table_lock = &shm->lock;
+    spare = NULL;
+  }
+
+  frame_attach(slot->frame, p);
+  success = pagedir_set_page(p->thread->pagedir, p->vaddr,
+                             slot->frame->kaddr, p->writable);
+  if (success)
+    pagedir_set_accessed(p->thread->pagedir, p->vaddr, true);
+  else
+    frame_detach(slot->frame, p);
+  lock_release(&shm->lock);
+
+  if (spare != NULL)
+    frame_free_frame(spare);
+  return success;
+}
+
+/* Writes the segment page that shared memory page P maps, held in the
+   frame at KADDR, to swap.  The caller holds the segment's lock, as
+   the frame's table lock, and has unmapped the frame from every
+   mapper. */
+void shm_evict(struct page *p, void *kaddr)
+{
+  struct shm_slot *slot = &p->shm->slots[p->ofs / PGSIZE];
+
+  ASSERT(lock_held_by_current_thread(&p->shm->lock));
+  slot->swap_id = swap_out(kaddr, p->shm);
+  slot->frame = NULL;
+}
@@ -0,0 +1,24 @@
+#ifndef VM_SHM_H
+#define VM_SHM_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+struct page;
+
+/* Longest name of a shared memory segment. */
+#define SHM_NAME_MAX 31
+
+/* Largest shared memory segment, in pages. */
+#define SHM_MAX_PAGES 1024
+
+void shm_init(void);
+int shm_open(const char *name, size_t size);
+void *shm_map(int shmid, void *addr);
+bool shm_unmap(void *addr);
+void shm_exit(void);
+
+bool shm_load(struct page *p);
+void shm_evict(struct page *p, void *kaddr);
+
+#endif /* vm/shm.h */
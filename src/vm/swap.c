@@ -3,7 +3,12 @@
 #include "devices/block.h"
 #include "lib/kernel/bitmap.h"
 #include "lib/stddef.h"
+#include <list.h>
+#include <string.h>
+#include "threads/malloc.h"
 #include "threads/synch.h"
+#include "vm/frame.h"
+#include "vm/zswap.h"
 
 #define SECTORS_PER_PAGE (PGSIZE / BLOCK_SECTOR_SIZE)
 
@@ -14,6 +19,36 @@ struct block *swap_block;
 /* Lock to prevent simultaneous access to the swap block */
 struct lock swap_lock;
 
+/* Owner of the page in each swap slot: the process, or the shared
+   memory segment, it belongs to.  Set once the page is written, so
+   read-ahead, which only brings in slots of the owner whose page
+   faulted, never sees a slot being written. */
+static const void **swap_owner;
+
+/* Slot allocated last, and its owner, so that the next page of the
+   same owner goes right after it. */
+static size_t swap_last_slot;
+static const void *swap_last_owner;
+
+/* A page read ahead from swap.  Its slot stays allocated and the page
+   stays swapped out until it faults, when swap_in() copies it from
+   here instead of reading the disk. */
+struct swap_cache_entry
+{
+    block_sector_t swap_id;     /* Slot the page was read from */
+    struct frame *frame;        /* Frame holding it, not mapped anywhere */
+    struct list_elem elem;      /* For swap_cache, oldest first */
+};
+
+/* The swap cache, guarded by swap_lock */
+static struct list swap_cache;
+static size_t swap_cache_cnt;
+
+/* Number of slots freed so far.  A slot can only be rewritten after
+   it is freed, so read-ahead that saw no free meanwhile read what it
+   meant to. */
+static unsigned swap_free_seq;
+
 /* Initialize the swap block and swap map */
 void swap_init(void)
 {
@@ -32,40 +67,288 @@ void swap_init(void)
         PANIC("couldn't create bitmap of swap block\n");
 
     bitmap_set_all(swap_map, 0);
+    swap_owner = calloc(bitmap_size(swap_map) + 1, sizeof *swap_owner);
+    if (swap_owner == NULL)
+        PANIC("couldn't allocate swap slot owners\n");
     lock_init(&swap_lock);
+    list_init(&swap_cache);
 }
 
-/* Swap out the page to the swap block */
-block_sector_t
-swap_out(void *kaddr)
+/* Write the page at kaddr to swap slot swap_id, one sector after
+   another.  The block device serializes requests per channel only, so
+   page-ins and page-outs of different threads proceed concurrently. */
+static void
+swap_write(void *kaddr, block_sector_t swap_id)
+{
+    for (int i = 0; i < SECTORS_PER_PAGE; i++)
+    {
+        block_write(swap_block, swap_id * SECTORS_PER_PAGE + i, kaddr);
+        kaddr += BLOCK_SECTOR_SIZE;
+    }
+}
+
+/* Read swap slot swap_id into the page at kaddr */
+static void
+swap_read(void *kaddr, block_sector_t swap_id)
 {
-    block_sector_t swap_id;
+    for (int i = 0; i < SECTORS_PER_PAGE; i++)
+    {
+        block_read(swap_block, swap_id * SECTORS_PER_PAGE + i, kaddr);
+        kaddr += BLOCK_SECTOR_SIZE;
+    }
+}
+
+/* Allocate cnt contiguous swap slots for pages of owner and return
+   the first, or BITMAP_ERROR if there is no such run.  Pages of one
+   owner are kept together: a single page goes right after the last
+   one of the same owner if that slot is free, and otherwise starts a
+   free run long enough for a cluster to follow it. */
+static block_sector_t
+swap_alloc(size_t cnt, const void *owner)
+{
+    size_t swap_id = BITMAP_ERROR;
+
     lock_acquire(&swap_lock);
-    swap_id = bitmap_scan_and_flip(swap_map, 0, 1, false);
+    if (cnt == 1 && owner == swap_last_owner
+        && swap_last_slot + 1 < bitmap_size(swap_map)
+        && !bitmap_test(swap_map, swap_last_slot + 1))
+        swap_id = swap_last_slot + 1;
+    else if (cnt == 1)
+        swap_id = bitmap_scan(swap_map, 0, SWAP_CLUSTER, false);
+    if (swap_id == BITMAP_ERROR)
+        swap_id = bitmap_scan(swap_map, 0, cnt, false);
+
+    if (swap_id != BITMAP_ERROR)
+    {
+        bitmap_set_multiple(swap_map, swap_id, cnt, true);
+        swap_last_slot = swap_id + cnt - 1;
+        swap_last_owner = owner;
+    }
     lock_release(&swap_lock);
+    return swap_id;
+}
+
+/* Record owner as the owner of the written swap slot swap_id */
+static void
+swap_set_owner(block_sector_t swap_id, const void *owner)
+{
+    lock_acquire(&swap_lock);
+    swap_owner[swap_id] = owner;
+    lock_release(&swap_lock);
+}
+
+/* Returns the number of swap slots */
+size_t swap_slot_cnt(void)
+{
+    return swap_map != NULL ? bitmap_size(swap_map) : 0;
+}
+
+/* Returns the number of swap slots in use */
+size_t swap_used_cnt(void)
+{
+    size_t cnt;
+
+    if (swap_map == NULL)
+        return 0;
+    lock_acquire(&swap_lock);
+    cnt = bitmap_count(swap_map, 0, bitmap_size(swap_map), true);
+    lock_release(&swap_lock);
+    return cnt;
+}
+
+/* Write the page of owner at kaddr to its swap slot swap_id on the
+   swap block, for the compressed swap pool */
+void swap_write_back(block_sector_t swap_id, void *kaddr, const void *owner)
+{
+    swap_write(kaddr, swap_id);
+    swap_set_owner(swap_id, owner);
+}
+
+/* Swap out the page of owner at kaddr, to the compressed swap pool
+   if it takes it and to the swap block otherwise */
+block_sector_t
+swap_out(void *kaddr, const void *owner)
+{
+    block_sector_t swap_id = swap_alloc(1, owner);
 
     if (swap_id == BITMAP_ERROR)
     {
         PANIC("SWAP SPACE FULL!");
     }
 
-    for (int i = 0; i < SECTORS_PER_PAGE; i++)
+    if (!zswap_store(swap_id, kaddr, owner))
+        swap_write_back(swap_id, kaddr, owner);
+    return swap_id;
+}
+
+/* Swap out the cnt pages at kaddrs, all of owner, storing the slot of
+   each in swap_ids.  The pages go to contiguous slots, so that they
+   are written as one sequential run, unless swap is too fragmented. */
+void swap_out_cluster(void **kaddrs, size_t cnt, const void *owner,
+                      block_sector_t *swap_ids)
+{
+    block_sector_t first = swap_alloc(cnt, owner);
+    size_t i;
+
+    for (i = 0; i < cnt; i++)
     {
-        block_write(swap_block, swap_id * SECTORS_PER_PAGE + i, kaddr);
-        kaddr += BLOCK_SECTOR_SIZE;
+        if (first == BITMAP_ERROR)
+            swap_ids[i] = swap_out(kaddrs[i], owner);
+        else
+        {
+            swap_ids[i] = first + i;
+            if (!zswap_store(swap_ids[i], kaddrs[i], owner))
+                swap_write_back(swap_ids[i], kaddrs[i], owner);
+        }
     }
+}
 
-    return swap_id;
+/* Returns the swap cache entry for swap_id, or NULL.  Caller holds
+   swap_lock. */
+static struct swap_cache_entry *
+swap_cache_find(block_sector_t swap_id)
+{
+    struct list_elem *e;
+    for (e = list_begin(&swap_cache); e != list_end(&swap_cache); e = list_next(e))
+    {
+        struct swap_cache_entry *c = list_entry(e, struct swap_cache_entry, elem);
+        if (c->swap_id == swap_id)
+            return c;
+    }
+    return NULL;
+}
+
+/* Removes swap cache entry c and frees its frame.  Caller holds
+   swap_lock, which is dropped meanwhile. */
+static void
+swap_cache_drop(struct swap_cache_entry *c)
+{
+    list_remove(&c->elem);
+    swap_cache_cnt--;
+    lock_release(&swap_lock);
+    frame_free_frame(c->frame);
+    free(c);
+    lock_acquire(&swap_lock);
+}
+
+/* Reads slot swap_id into the swap cache, if it still holds a page of
+   owner that is not cached yet, there is room in the cache and a free
+   frame.  Returns false if reading ahead should stop. */
+static bool
+swap_read_ahead(block_sector_t swap_id, const void *owner)
+{
+    struct swap_cache_entry *c;
+    struct frame *frame;
+    unsigned free_seq;
+    bool wanted;
+
+    lock_acquire(&swap_lock);
+    if (swap_cache_cnt >= SWAP_CACHE_MAX)
+    {
+        lock_release(&swap_lock);
+        return false;
+    }
+    wanted = bitmap_test(swap_map, swap_id) && swap_owner[swap_id] == owner
+             && swap_cache_find(swap_id) == NULL;
+    free_seq = swap_free_seq;
+    lock_release(&swap_lock);
+    if (!wanted)
+        return true;
+
+    /* Only use memory that is free anyway */
+    c = malloc(sizeof *c);
+    frame = c != NULL ? frame_try_get_frame(PAL_USER) : NULL;
+    if (frame == NULL)
+    {
+        free(c);
+        return false;
+    }
+    swap_read(frame->kaddr, swap_id);
+    c->swap_id = swap_id;
+    c->frame = frame;
+
+    /* The page may have faulted in or gone away meanwhile */
+    lock_acquire(&swap_lock);
+    wanted = free_seq == swap_free_seq && swap_cache_find(swap_id) == NULL;
+    if (wanted)
+    {
+        list_push_back(&swap_cache, &c->elem);
+        swap_cache_cnt++;
+    }
+    lock_release(&swap_lock);
+    if (!wanted)
+    {
+        frame_free_frame(frame);
+        free(c);
+    }
+    return true;
 }
 
-/* Swap in the page from the swap block */
+/* Swap in the page from the swap block, from the swap cache if it was
+   read ahead.  Otherwise also reads the following slots of the same
+   owner into the swap cache, since pages evicted together are usually
+   needed together. */
 void swap_in(void *kaddr, block_sector_t swap_id)
 {
+    struct swap_cache_entry *c;
+    const void *owner;
+    block_sector_t next;
+
     ASSERT(swap_id != BLOCK_SECTOR_NULL);
-    for (int i = 0; i < SECTORS_PER_PAGE; i++)
+    lock_acquire(&swap_lock);
+    owner = swap_owner[swap_id];
+    c = swap_cache_find(swap_id);
+    if (c != NULL)
     {
-        block_read(swap_block, swap_id * SECTORS_PER_PAGE + i, kaddr);
-        kaddr += BLOCK_SECTOR_SIZE;
+        memcpy(kaddr, c->frame->kaddr, PGSIZE);
+        swap_cache_drop(c);
     }
+    lock_release(&swap_lock);
+    if (c != NULL || zswap_load(swap_id, kaddr))
+    {
+        swap_free(swap_id);
+        return;
+    }
+
+    swap_read(kaddr, swap_id);
+    swap_free(swap_id);
+
+    for (next = swap_id + 1; next < swap_id + 1 + SWAP_READ_AHEAD
+                             && next < bitmap_size(swap_map); next++)
+        if (!swap_read_ahead(next, owner))
+            break;
+}
+
+/* Release a swap slot whose contents are no longer needed */
+void swap_free(block_sector_t swap_id)
+{
+    struct swap_cache_entry *c;
+
+    ASSERT(swap_id != BLOCK_SECTOR_NULL);
+    zswap_forget(swap_id);
+    lock_acquire(&swap_lock);
     bitmap_reset(swap_map, swap_id);
-}
\ No newline at end of file
+    swap_owner[swap_id] = NULL;
+    swap_free_seq++;
+    c = swap_cache_find(swap_id);
+    if (c != NULL)
+        swap_cache_drop(c);
+    lock_release(&swap_lock);
+}
+
+/* Frees up to cnt frames of the swap cache, oldest first, for memory
+   is short.  Their pages are still in swap.  Returns the number of
+   frames freed. */
+size_t swap_cache_shrink(size_t cnt)
+{
+    size_t done = 0;
+
+    lock_acquire(&swap_lock);
+    while (done < cnt && !list_empty(&swap_cache))
+    {
+        swap_cache_drop(list_entry(list_front(&swap_cache), struct swap_cache_entry, elem));
+        done++;
+    }
+    lock_release(&swap_lock);
+    return done;
+}
@@ -5,7 +5,22 @@
 #include "devices/block.h"
 
 void swap_init(void);
-block_sector_t swap_out(void *kaddr);
+/* Most pages the page-out daemon writes to swap in one run. */
+#define SWAP_CLUSTER 8
+
+/* Slots read ahead after each swap-in, and most pages kept read
+   ahead. */
+#define SWAP_READ_AHEAD 4
+#define SWAP_CACHE_MAX 32
+
+block_sector_t swap_out(void *kaddr, const void *owner);
+void swap_out_cluster(void **kaddrs, size_t cnt, const void *owner,
+                      block_sector_t *swap_ids);
+size_t swap_cache_shrink(size_t cnt);
 void swap_in(void *kaddr, block_sector_t swap_id);
+size_t swap_slot_cnt(void);
+size_t swap_used_cnt(void);
+void swap_write_back(block_sector_t swap_id, void *kaddr, const void *owner);
+void swap_free(block_sector_t swap_id);
 
 #endif
\ No newline at end of file
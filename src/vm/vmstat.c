@@ -0,0 +1,76 @@
+#include "vm/vmstat.h"
+#include <stdio.h>
+#include "threads/thread.h"
+#include "vm/frame.h"
+#include "vm/page.h"
+#include "vm/swap.h"
+
+/* Counts of each event since boot.  Bumped without a lock, so a count
+   may now and then miss a concurrent event. */
+static unsigned vmstat_events[VMSTAT_EVENT_CNT];
+
+/* True if every process prints its statistics when it exits. */
+static bool vmstat_print_exit;
+
+/* Sets whether processes print their statistics when they exit. */
+void vmstat_init(bool print_exit)
+{
+  vmstat_print_exit = print_exit;
+}
+
+/* Counts one occurrence of event. */
+void vmstat_count(enum vmstat_event event)
+{
+  ASSERT(event < VMSTAT_EVENT_CNT);
+  vmstat_events[event]++;
+}
+
+/* Fills st with the statistics of the whole system and of the current
+   process. */
+void vmstat_get(struct vmstat *st)
+{
+  struct thread *cur = thread_current();
+  size_t resident, swapped;
+
+  st->zero_faults = vmstat_events[VMSTAT_ZERO_FAULT];
+  st->file_faults = vmstat_events[VMSTAT_FILE_FAULT];
+  st->swap_faults = vmstat_events[VMSTAT_SWAP_FAULT];
+  st->stack_faults = vmstat_events[VMSTAT_STACK_FAULT];
+  st->clean_evictions = vmstat_events[VMSTAT_CLEAN_EVICT];
+  st->dirty_evictions = vmstat_events[VMSTAT_DIRTY_EVICT];
+  st->frames = frame_total_cnt();
+  st->frames_used = frame_used_cnt();
+  st->swap_slots = swap_slot_cnt();
+  st->swap_used = swap_used_cnt();
+
+  page_count(&resident, &swapped);
+  st->page_faults = cur->page_faults;
+  st->resident_pages = resident;
+  st->swapped_pages = swapped;
+}
+
+/* Prints the statistics of the exiting process, if asked to at boot.
+   Must run before its supplemental page table goes away. */
+void vmstat_exit(void)
+{
+  struct thread *cur = thread_current();
+  size_t resident, swapped;
+
+  if (!vmstat_print_exit || cur->supl_pt == NULL)
+    return;
+  page_count(&resident, &swapped);
+  printf("%s: vm: %u page faults, %zu pages resident, %zu swapped\n",
+         cur->name, cur->page_faults, resident, swapped);
+}
+
+/* Prints the statistics of the whole system. */
+void vmstat_print_stats(void)
+{
+  printf("VM: %u zero-fill, %u file, %u swap-in, %u stack growth faults\n",
+         vmstat_events[VMSTAT_ZERO_FAULT], vmstat_events[VMSTAT_FILE_FAULT],
+         vmstat_events[VMSTAT_SWAP_FAULT], vmstat_events[VMSTAT_STACK_FAULT]);
+  printf("VM: %u clean, %u dirty evictions\n",
+         vmstat_events[VMSTAT_CLEAN_EVICT], vmstat_events[VMSTAT_DIRTY_EVICT]);
+  printf("VM: %zu of %zu frames, %zu of %zu swap slots in use\n",
+         frame_used_cnt(), frame_total_cnt(), swap_used_cnt(), swap_slot_cnt());
+}
@@ -0,0 +1,25 @@
+#ifndef VM_VMSTAT_H
+#define VM_VMSTAT_H
+
+#include <stdbool.h>
+#include <vmstat.h>
+
+/* Events counted for the whole system. */
+enum vmstat_event
+{
+  VMSTAT_ZERO_FAULT,  /* A page was filled with zeros. */
+  VMSTAT_FILE_FAULT,  /* A page was read from a file. */
+  VMSTAT_SWAP_FAULT,  /* A page was read back from swap. */
+  VMSTAT_STACK_FAULT, /* A stack grew. */
+  VMSTAT_CLEAN_EVICT, /* A frame was evicted without a write. */
+  VMSTAT_DIRTY_EVICT, /* A frame was written out when evicted. */
+  VMSTAT_EVENT_CNT
+};
+
+void vmstat_init(bool print_exit);
+void vmstat_count(enum vmstat_event event);
+void vmstat_get(struct vmstat *st);
+void vmstat_exit(void);
+void vmstat_print_stats(void);
+
+#endif /* vm/vmstat.h */
@@ -0,0 +1,348 @@
+#include "vm/zswap.h"
+#include <debug.h>
+#include <list.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "threads/malloc.h"
+#include "threads/palloc.h"
+#include "threads/synch.h"
+#include "vm/swap.h"
+
+/* A compressed page kept in the pool instead of on the swap device.
+   Its swap slot stays allocated, so that it can be written there
+   when it grows cold or the pool fills up. */
+struct zswap_entry
+{
+  block_sector_t swap_id;     /* Swap slot of the page. */
+  const void *owner;          /* Owner of the page, for swap. */
+  size_t pool_page;           /* Pool page holding it. */
+  bool last;                  /* True if at the end of that page. */
+  size_t size;                /* Compressed size. */
+  struct list_elem elem;      /* For zswap_lru. */
+};
+
+/* The pool.  Each page holds up to two compressed pages, one from
+   its start and one from its end, in the way of a buddy allocator
+   ("zbud"), so that freeing never needs compaction. */
+static uint8_t **zswap_pool;
+static size_t zswap_pool_pages;
+static size_t *zswap_first;   /* Bytes used at the start of each pool page. */
+static size_t *zswap_last;    /* Bytes used at the end of each pool page. */
+
+/* Entry of each swap slot held in the pool, or NULL. */
+static struct zswap_entry **zswap_slots;
+
+/* Entries, least recently stored first. */
+static struct list zswap_lru;
+
+/* Guards everything above, the buffers and the compressor's table. */
+static struct lock zswap_lock;
+
+/* Page-sized buffers for compressing and for writing back. */
+static uint8_t *zswap_cbuf;
+static uint8_t *zswap_dbuf;
+
+/* Statistics. */
+static unsigned zswap_stored;       /* Pages stored. */
+static unsigned zswap_rejected;     /* Pages that compressed too poorly. */
+static unsigned zswap_written_back; /* Pages moved on to the swap device. */
+static unsigned zswap_lookups;      /* Swap-ins that asked the pool. */
+static unsigned zswap_hits;         /* Swap-ins it satisfied. */
+static unsigned long long zswap_bytes_in;  /* Bytes before compression. */
+static unsigned long long zswap_bytes_out; /* Bytes after compression. */
+
+/* LZ compression, in the manner of LZRW1.
+   Items come in groups of up to 16, each group preceded by a 16-bit
+   little-endian control word with one bit per item.  A clear bit is
+   a literal byte.  A set bit is a 2-byte copy of 3 to 18 bytes from
+   1 to 4095 bytes back: the low 8 bits of the distance, then its
+   high 4 bits above the length minus 3. */
+#define LZ_HASH_BITS 10
+#define LZ_MIN_MATCH 3
+#define LZ_MAX_MATCH 18
+#define LZ_MAX_DIST 4095
+
+/* Position plus one of the last string of each hash, or 0. */
+static uint16_t lz_table[1 << LZ_HASH_BITS];
+
+/* Returns the hash of the 3 bytes at p. */
+static unsigned
+lz_hash(const uint8_t *p)
+{
+  return ((p[0] << 8) ^ (p[1] << 4) ^ p[2]) * 2654435761u >> (32 - LZ_HASH_BITS);
+}
+
+/* Compresses the len bytes at src into dst.  Returns the compressed
+   size, or 0 if it would exceed cap. */
+static size_t
+lz_compress(const uint8_t *src, size_t len, uint8_t *dst, size_t cap)
+{
+  const uint8_t *ip = src, *end = src + len;
+  uint8_t *op = dst + 2, *ctrl_p = dst, *op_end = dst + cap;
+  unsigned ctrl = 0, ctrl_bits = 0;
+
+  if (cap < 2)
+    return 0;
+  memset(lz_table, 0, sizeof lz_table);
+  while (ip < end)
+  {
+    size_t match = 0, dist = 0;
+
+    if (ctrl_bits == 16)
+    {
+      ctrl_p[0] = ctrl;
+      ctrl_p[1] = ctrl >> 8;
+      ctrl_p = op;
+      op += 2;
+      ctrl = ctrl_bits = 0;
+    }
+    if (op + 2 > op_end)
+      return 0;
+
+    if (end - ip >= LZ_MIN_MATCH)
+    {
+      unsigned h = lz_hash(ip);
+      size_t cand = lz_table[h];
+      lz_table[h] = ip - src + 1;
+      if (cand != 0 && (size_t)(ip - src) - (cand - 1) <= LZ_MAX_DIST)
+      {
+        const uint8_t *m = src + cand - 1;
+        size_t max = end - ip < LZ_MAX_MATCH ? (size_t)(end - ip) : LZ_MAX_MATCH;
+        dist = ip - m;
+        while (match < max && m[match] == ip[match])
+          match++;
+      }
+    }
+
+    if (match >= LZ_MIN_MATCH)
+    {
+      ctrl |= 1u << ctrl_bits;
+      *op++ = dist & 0xff;
+      *op++ = (dist >> 8) << 4 | (match - LZ_MIN_MATCH);
+      ip += match;
+    }
+    else
+      *op++ = *ip++;
+    ctrl_bits++;
+  }
+  ctrl_p[0] = ctrl;
+  ctrl_p[1] = ctrl >> 8;
+  return op - dst;
+}
+
+/* Decompresses the len bytes at src, made by lz_compress(), into dst. */
+static void
+lz_decompress(const uint8_t *src, size_t len, uint8_t *dst)
+{
+  const uint8_t *ip = src, *end = src + len;
+  uint8_t *op = dst;
+
+  while (ip < end)
+  {
+    unsigned ctrl = ip[0] | ip[1] << 8;
+    unsigned bit;
+
+    ip += 2;
+    for (bit = 0; bit < 16 && ip < end; bit++)
+    {
+      if (ctrl & (1u << bit))
+      {
+        size_t dist = ip[0] | (ip[1] >> 4) << 8;
+        size_t n = (ip[1] & 0xf) + LZ_MIN_MATCH;
+        const uint8_t *m = op - dist;
+        ip += 2;
+        while (n-- > 0)
+          *op++ = *m++;
+      }
+      else
+        *op++ = *ip++;
+    }
+  }
+}
+
+/* Sets up a pool of pool_pages kernel pages for the swap device's
+   slot_cnt slots.  The pool stays disabled if pool_pages is 0 or
+   memory runs out. */
+void zswap_init(size_t pool_pages, size_t slot_cnt)
+{
+  size_t i;
+
+  if (pool_pages == 0 || slot_cnt == 0)
+    return;
+
+  zswap_pool = malloc(pool_pages * sizeof *zswap_pool);
+  zswap_first = calloc(pool_pages, sizeof *zswap_first);
+  zswap_last = calloc(pool_pages, sizeof *zswap_last);
+  zswap_cbuf = palloc_get_page(0);
+  zswap_dbuf = palloc_get_page(0);
+  if (zswap_pool == NULL || zswap_first == NULL || zswap_last == NULL
+      || zswap_cbuf == NULL || zswap_dbuf == NULL)
+    PANIC("couldn't allocate compressed swap pool");
+  for (i = 0; i < pool_pages; i++)
+  {
+    zswap_pool[i] = palloc_get_page(0);
+    if (zswap_pool[i] == NULL)
+      break;
+  }
+  zswap_pool_pages = i;
+
+  list_init(&zswap_lru);
+  lock_init(&zswap_lock);
+  zswap_slots = calloc(slot_cnt, sizeof *zswap_slots);
+  if (zswap_slots == NULL)
+    PANIC("couldn't allocate compressed swap slots");
+  printf("zswap: %zu pages of compressed swap.\n", zswap_pool_pages);
+}
+
+/* Removes entry e from the pool and frees it.  Caller holds
+   zswap_lock. */
+static void
+zswap_remove(struct zswap_entry *e)
+{
+  if (e->last)
+    zswap_last[e->pool_page] = 0;
+  else
+    zswap_first[e->pool_page] = 0;
+  list_remove(&e->elem);
+  zswap_slots[e->swap_id] = NULL;
+  free(e);
+}
+
+/* Writes the coldest page in the pool to its swap slot and removes it.
+   Returns false if the pool is empty.  Caller holds zswap_lock. */
+static bool
+zswap_write_back(void)
+{
+  struct zswap_entry *e;
+
+  if (list_empty(&zswap_lru))
+    return false;
+  e = list_entry(list_front(&zswap_lru), struct zswap_entry, elem);
+  lz_decompress(zswap_pool[e->pool_page] + (e->last ? PGSIZE - e->size : 0),
+                e->size, zswap_dbuf);
+  swap_write_back(e->swap_id, zswap_dbuf, e->owner);
+  zswap_remove(e);
+  zswap_written_back++;
+  return true;
+}
+
+/* Finds room for size bytes in the pool, writing cold pages back to
+   swap as needed.  Sets *page and *last to where they go and returns
+   true, or returns false if the pool cannot hold them.  Caller holds
+   zswap_lock. */
+static bool
+zswap_find_room(size_t size, size_t *page, bool *last)
+{
+  do
+  {
+    size_t i;
+    for (i = 0; i < zswap_pool_pages; i++)
+    {
+      if (zswap_first[i] + zswap_last[i] + size > PGSIZE)
+        continue;
+      if (zswap_first[i] == 0 || zswap_last[i] == 0)
+      {
+        *page = i;
+        *last = zswap_first[i] != 0;
+        return true;
+      }
+    }
+  } while (zswap_write_back());
+  return false;
+}
+
+/* Compresses the page at kaddr, whose swap slot swap_id belongs to
+   owner, into the pool.  Returns false if the pool is disabled or the
+   page compresses too poorly, in which case it goes to the swap
+   device. */
+bool zswap_store(block_sector_t swap_id, const void *kaddr, const void *owner)
+{
+  struct zswap_entry *e;
+  size_t size, page;
+  bool last;
+
+  if (zswap_slots == NULL)
+    return false;
+  e = malloc(sizeof *e);
+  if (e == NULL)
+    return false;
+
+  lock_acquire(&zswap_lock);
+  size = lz_compress(kaddr, PGSIZE, zswap_cbuf, ZSWAP_MAX_SIZE);
+  if (size == 0 || !zswap_find_room(size, &page, &last))
+  {
+    zswap_rejected++;
+    lock_release(&zswap_lock);
+    free(e);
+    return false;
+  }
+
+  memcpy(zswap_pool[page] + (last ? PGSIZE - size : 0), zswap_cbuf, size);
+  if (last)
+    zswap_last[page] = size;
+  else
+    zswap_first[page] = size;
+  e->swap_id = swap_id;
+  e->owner = owner;
+  e->pool_page = page;
+  e->last = last;
+  e->size = size;
+  list_push_back(&zswap_lru, &e->elem);
+  zswap_slots[swap_id] = e;
+
+  zswap_stored++;
+  zswap_bytes_in += PGSIZE;
+  zswap_bytes_out += size;
+  lock_release(&zswap_lock);
+  return true;
+}
+
+/* Decompresses the page in swap slot swap_id into kaddr if the pool
+   holds it, and removes it from the pool.  Returns false if the page
+   is on the swap device instead. */
+bool zswap_load(block_sector_t swap_id, void *kaddr)
+{
+  struct zswap_entry *e;
+
+  if (zswap_slots == NULL)
+    return false;
+
+  lock_acquire(&zswap_lock);
+  zswap_lookups++;
+  e = zswap_slots[swap_id];
+  if (e != NULL)
+  {
+    lz_decompress(zswap_pool[e->pool_page] + (e->last ? PGSIZE - e->size : 0),
+                  e->size, kaddr);
+    zswap_remove(e);
+    zswap_hits++;
+  }
+  lock_release(&zswap_lock);
+  return e != NULL;
+}
+
+/* Drops the page in swap slot swap_id from the pool, if there. */
+void zswap_forget(block_sector_t swap_id)
+{
+  if (zswap_slots == NULL)
+    return;
+
+  lock_acquire(&zswap_lock);
+  if (zswap_slots[swap_id] != NULL)
+    zswap_remove(zswap_slots[swap_id]);
+  lock_release(&zswap_lock);
+}
+
+/* Prints compressed swap statistics. */
+void zswap_print_stats(void)
+{
+  if (zswap_slots == NULL)
+    return;
+
+  printf("zswap: %u pages stored, %u rejected, %u written back\n",
+         zswap_stored, zswap_rejected, zswap_written_back);
+  printf("zswap: compressed to %u%% of original size, %u hits of %u swap-ins\n",
+         zswap_bytes_in != 0 ? (unsigned)(zswap_bytes_out * 100 / zswap_bytes_in) : 0,
+         zswap_hits, zswap_lookups);
+}
@@ -0,0 +1,19 @@
+#ifndef VM_ZSWAP_H
+#define VM_ZSWAP_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "devices/block.h"
+#include "threads/vaddr.h"
+
+/* Largest compressed size of a page kept in memory.  Pages that
+   compress worse go straight to the swap device. */
+#define ZSWAP_MAX_SIZE (PGSIZE * 3 / 4)
+
+void zswap_init(size_t pool_pages, size_t slot_cnt);
+bool zswap_store(block_sector_t swap_id, const void *kaddr, const void *owner);
+bool zswap_load(block_sector_t swap_id, void *kaddr);
+void zswap_forget(block_sector_t swap_id);
+void zswap_print_stats(void);
+
+#endif /* vm/zswap.h */